@@ -0,0 +1,27 @@
+#pragma once
+#include <Arduino.h>
+#include "LittleFS.h"
+#include "config.h"
+
+// Attendance log on LittleFS, one "unixtime,id,confidence" line per scan
+
+#define ATTENDANCE_PATH "/attendance.csv"
+
+bool logAttendance(uint16_t id, uint16_t confidence) {
+    File file = LittleFS.open(ATTENDANCE_PATH, FILE_APPEND);
+    if (!file) {
+        Serial.println("Attendance: Failed to open log for writing");
+        return false;
+    }
+
+    char line[32];
+    int len = snprintf(line, sizeof(line), "%lu,%u,%u\n",
+                       (unsigned long)rtcNow().unixtime(), id, confidence);
+    bool ok = file.write((const uint8_t*)line, len) == (size_t)len;
+    file.close();
+
+    if (!ok) {
+        Serial.println("Attendance: Write failed");
+    }
+    return ok;
+}
@@ -0,0 +1,286 @@
+#pragma once
+#include <Arduino.h>
+#include <ESPAsyncWebServer.h>
+#include "LittleFS.h"
+#include "attendance.h"
+#include "attendance_format.h"
+#include "supervisor.h"
+
+// Compact attendance export (format in attendance_format.h), decoded on a PC
+// with tools/export.
+//
+// The log is read and encoded one block at a time, so an export needs the
+// same <2KB of RAM for ten entries or a hundred thousand. Only one HTTP
+// export runs at a time; a second request gets 503 instead of more buffers.
+
+#define ATTENDANCE_EXPORT_PATH "/attendance.bin"
+#define EXPORT_LINE_MAX 32
+#define EXPORT_READ_CHUNK 128
+
+class AttendanceExporter {
+public:
+    bool begin() {
+        file = LittleFS.open(ATTENDANCE_PATH, FILE_READ);
+        if (!file) {
+            return false;
+        }
+        readLen = readPos = 0;
+        lineLen = 0;
+        exported = skipped = 0;
+        finished = false;
+        outLen = exportWriteHeader(block);
+        outPos = 0;
+        return true;
+    }
+
+    void end() {
+        file.close();
+    }
+
+    // Next bytes of the export, 0 once the end block has been handed out
+    size_t read(uint8_t* out, size_t maxLen) {
+        size_t n = 0;
+        while (n < maxLen) {
+            if (outPos == outLen && !fill()) {
+                break;
+            }
+            size_t chunk = min(maxLen - n, outLen - outPos);
+            memcpy(out + n, block + outPos, chunk);
+            outPos += chunk;
+            n += chunk;
+        }
+        return n;
+    }
+
+    uint32_t exported = 0;
+    uint32_t skipped = 0;
+
+private:
+    // Encodes the next block, or the end block once the log runs out
+    bool fill() {
+        if (finished) {
+            return false;
+        }
+
+        uint16_t count = 0;
+        char line[EXPORT_LINE_MAX];
+        while (count < EXPORT_BLOCK_RECORDS && readLine(line)) {
+            if (exportParseLine(line, records[count])) {
+                count++;
+            } else {
+                skipped++;
+            }
+        }
+
+        if (count > 0) {
+            outLen = exportEncodeBlock(block, records, count);
+            exported += count;
+        } else {
+            outLen = exportEncodeEnd(block, exported, skipped);
+            finished = true;
+        }
+        outPos = 0;
+        return true;
+    }
+
+    // Overlong lines come back empty, so they are counted as skipped
+    bool readLine(char* line) {
+        for (;;) {
+            if (readPos == readLen) {
+                readLen = file.read(readBuffer, sizeof(readBuffer));
+                readPos = 0;
+                if (readLen == 0) {
+                    // A last line without newline was cut off mid-write
+                    if (lineLen == 0) {
+                        return false;
+                    }
+                    line[0] = '\0';
+                    lineLen = 0;
+                    return true;
+                }
+            }
+
+            char c = readBuffer[readPos++];
+            if (c == '\n') {
+                bool fits = lineLen < EXPORT_LINE_MAX;
+                if (fits) {
+                    memcpy(line, lineBuffer, lineLen);
+                }
+                line[fits ? lineLen : 0] = '\0';
+                lineLen = 0;
+                return true;
+            }
+            if (lineLen < EXPORT_LINE_MAX - 1) {
+                lineBuffer[lineLen] = c;
+            }
+            if (lineLen < EXPORT_LINE_MAX) {
+                lineLen++;
+            }
+        }
+    }
+
+    File file;
+    uint8_t readBuffer[EXPORT_READ_CHUNK];
+    size_t readLen = 0;
+    size_t readPos = 0;
+    char lineBuffer[EXPORT_LINE_MAX];
+    size_t lineLen = 0;
+    ExportRecord records[EXPORT_BLOCK_RECORDS];
+    uint8_t block[EXPORT_BLOCK_MAX];
+    size_t outLen = 0;
+    size_t outPos = 0;
+    bool finished = false;
+};
+
+static AttendanceExporter exportStream;
+static bool exportBusy = false;
+static uint32_t exportGeneration = 0;
+static unsigned long exportStartedAt = 0;
+static size_t exportBytes = 0;
+static portMUX_TYPE exportMux = portMUX_INITIALIZER_UNLOCKED;
+
+// Statistics
+static uint32_t exportRuns = 0;
+static uint32_t exportRejected = 0;
+static uint32_t exportLastRecords = 0;
+static uint32_t exportLastBytes = 0;
+static uint32_t exportLastMs = 0;
+
+// Runs in the async_tcp task, from the last chunk or a disconnect
+static void exportFinish(uint32_t generation) {
+    portENTER_CRITICAL(&exportMux);
+    bool current = exportBusy && generation == exportGeneration;
+    portEXIT_CRITICAL(&exportMux);
+    if (!current) {
+        return;
+    }
+
+    exportStream.end();
+    exportLastRecords = exportStream.exported;
+    exportLastBytes = exportBytes;
+    exportLastMs = millis() - exportStartedAt;
+    Serial.println("Export: " + String(exportLastRecords) + " records, " + String(exportStream.skipped) +
+                   " skipped, " + String(exportLastBytes) + "B in " + String(exportLastMs) + "ms");
+
+    portENTER_CRITICAL(&exportMux);
+    exportBusy = false;
+    portEXIT_CRITICAL(&exportMux);
+}
+
+// Runs in the async_tcp task
+static void exportHandleRequest(AsyncWebServerRequest* request) {
+    portENTER_CRITICAL(&exportMux);
+    bool busy = exportBusy;
+    exportBusy = true;
+    uint32_t generation = busy ? exportGeneration : ++exportGeneration;
+    portEXIT_CRITICAL(&exportMux);
+
+    if (busy) {
+        exportRejected++;
+        request->send(503, "text/plain", "Export already running");
+        return;
+    }
+    if (!exportStream.begin()) {
+        portENTER_CRITICAL(&exportMux);
+        exportBusy = false;
+        portEXIT_CRITICAL(&exportMux);
+        request->send(404, "text/plain", "No attendance log");
+        return;
+    }
+    exportRuns++;
+    exportStartedAt = millis();
+    exportBytes = 0;
+
+    AsyncWebServerResponse* response = request->beginChunkedResponse("application/octet-stream",
+        [generation](uint8_t* buffer, size_t maxLen, size_t index) -> size_t {
+            size_t n = exportStream.read(buffer, maxLen);
+            exportBytes += n;
+            if (n == 0) {
+                exportFinish(generation);
+            }
+            return n;
+        });
+    response->addHeader("Content-Disposition", "attachment; filename=\"attendance.bin\"");
+    request->onDisconnect([generation]() { exportFinish(generation); });
+    request->send(response);
+}
+
+void initAttendanceExport(AsyncWebServer* server) {
+    server->on(ATTENDANCE_EXPORT_PATH, HTTP_GET, exportHandleRequest);
+}
+
+// Sizes and encode time of the compact export vs the same log as JSON
+// ([{"time":..,"id":..,"confidence":..},...]), both to a null sink
+void benchmarkAttendanceExport() {
+    portENTER_CRITICAL(&exportMux);
+    bool busy = exportBusy;
+    exportBusy = true;
+    portEXIT_CRITICAL(&exportMux);
+    if (busy) {
+        Serial.println("Export bench: an HTTP export is running");
+        return;
+    }
+
+    SupervisedScope scope(OP_BENCHMARK);
+    AttendanceExporter& exporter = exportStream;
+    uint8_t buffer[256];
+
+    File file = LittleFS.open(ATTENDANCE_PATH, FILE_READ);
+    if (!file) {
+        Serial.println("Export bench: no attendance log");
+        portENTER_CRITICAL(&exportMux);
+        exportBusy = false;
+        portEXIT_CRITICAL(&exportMux);
+        return;
+    }
+    size_t csvBytes = file.size();
+    file.close();
+
+    unsigned long start = micros();
+    size_t compactBytes = 0;
+    size_t n;
+    if (exporter.begin()) {
+        while ((n = exporter.read(buffer, sizeof(buffer))) > 0) {
+            compactBytes += n;
+        }
+        exporter.end();
+    }
+    unsigned long compactUs = micros() - start;
+
+    // JSON straight from the log, line by line like the exporter reads it
+    start = micros();
+    size_t jsonBytes = 1;
+    uint32_t records = 0;
+    file = LittleFS.open(ATTENDANCE_PATH, FILE_READ);
+    while (file.available()) {
+        String line = file.readStringUntil('\n');
+        ExportRecord record;
+        if (!exportParseLine(line.c_str(), record)) {
+            continue;
+        }
+        int len = snprintf((char*)buffer, sizeof(buffer), "%s{\"time\":%lu,\"id\":%u,\"confidence\":%u}",
+                           records ? "," : "[", (unsigned long)record.time, record.id, record.confidence);
+        jsonBytes += len;
+        records++;
+    }
+    file.close();
+    unsigned long jsonUs = micros() - start;
+
+    portENTER_CRITICAL(&exportMux);
+    exportBusy = false;
+    portEXIT_CRITICAL(&exportMux);
+
+    Serial.println("=== Export benchmark: " + String(records) + " records ===");
+    Serial.println("CSV log:  " + String(csvBytes) + "B");
+    Serial.println("JSON:     " + String(jsonBytes) + "B in " + String(jsonUs) + "us");
+    Serial.println("Compact:  " + String(compactBytes) + "B in " + String(compactUs) + "us (" +
+                   String(compactBytes * 100 / max(jsonBytes, (size_t)1)) + "% of JSON, " +
+                   String(exporter.skipped) + " lines skipped)");
+}
+
+void printExportStats() {
+    Serial.println("Export runs: " + String(exportRuns) +
+                   " rejected: " + String(exportRejected) +
+                   " last: " + String(exportLastRecords) + " records " + String(exportLastBytes) + "B " +
+                   String(exportLastMs) + "ms");
+}
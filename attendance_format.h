@@ -0,0 +1,209 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include <stdlib.h>
+
+// Compact attendance export format, shared by the firmware (attendance_export.h)
+// and the host decoder in tools/export. Plain C++ only, no Arduino types.
+//
+// Layout (multi-byte integers little-endian):
+//   header: magic "ISTA", u8 version, u8 reserved, u16 records per block
+//   blocks: u16 count, u16 payload length, payload, u32 CRC-32 of the
+//           preceding count, length and payload bytes
+//
+// A block payload is columnar: all timestamps, then all IDs, then all
+// confidences, each as an unsigned LEB128 varint. The first timestamp of a
+// block is absolute, the rest are zigzag deltas to the previous one (the
+// DS3231 can be set back), so every block decodes on its own. The stream
+// ends with a block of count 0 whose payload is the varint number of
+// records exported and of log lines skipped as unreadable.
+
+#define EXPORT_MAGIC 0x41545349UL  // "ISTA"
+#define EXPORT_VERSION 1
+#define EXPORT_HEADER_LEN 8
+#define EXPORT_BLOCK_RECORDS 64
+#define EXPORT_VARINT_MAX 5
+#define EXPORT_BLOCK_OVERHEAD 8
+#define EXPORT_BLOCK_MAX (EXPORT_BLOCK_OVERHEAD + EXPORT_BLOCK_RECORDS * 3 * EXPORT_VARINT_MAX)
+
+struct ExportRecord {
+    uint32_t time;
+    uint16_t id;
+    uint16_t confidence;
+};
+
+enum ExportStatus {
+    EXPORT_OK,
+    EXPORT_END,          // end block reached
+    EXPORT_SHORT,        // more bytes needed
+    EXPORT_BAD_CRC,
+    EXPORT_BAD_BLOCK
+};
+
+// CRC-32 (IEEE), half a byte at a time so the table stays at 64 bytes
+inline uint32_t exportCrc32(uint32_t crc, const uint8_t* data, size_t len) {
+    static const uint32_t table[16] = {
+        0x00000000, 0x1DB71064, 0x3B6E20C8, 0x26D930AC, 0x76DC4190, 0x6B6B51F4, 0x4DB26158, 0x5005713C,
+        0xEDB88320, 0xF00F9344, 0xD6D6A3E8, 0xCB61B38C, 0x9B64C2B0, 0x86D3D2D4, 0xA00AE278, 0xBDBDF21C};
+    crc = ~crc;
+    for (size_t i = 0; i < len; i++) {
+        crc = table[(crc ^ data[i]) & 0x0F] ^ (crc >> 4);
+        crc = table[(crc ^ (data[i] >> 4)) & 0x0F] ^ (crc >> 4);
+    }
+    return ~crc;
+}
+
+inline size_t exportPutVarint(uint8_t* out, uint32_t v) {
+    size_t n = 0;
+    while (v >= 0x80) {
+        out[n++] = (uint8_t)v | 0x80;
+        v >>= 7;
+    }
+    out[n++] = (uint8_t)v;
+    return n;
+}
+
+inline bool exportGetVarint(const uint8_t*& p, const uint8_t* end, uint32_t& v) {
+    v = 0;
+    for (int shift = 0; shift < 7 * EXPORT_VARINT_MAX && p < end; shift += 7) {
+        uint8_t b = *p++;
+        v |= (uint32_t)(b & 0x7F) << shift;
+        if ((b & 0x80) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+inline uint32_t exportZigzag(int32_t v) { return ((uint32_t)v << 1) ^ (uint32_t)(v >> 31); }
+inline int32_t exportUnzigzag(uint32_t v) { return (int32_t)(v >> 1) ^ -(int32_t)(v & 1); }
+
+inline void exportPut16(uint8_t* out, uint16_t v) {
+    out[0] = v;
+    out[1] = v >> 8;
+}
+
+inline void exportPut32(uint8_t* out, uint32_t v) {
+    exportPut16(out, v);
+    exportPut16(out + 2, v >> 16);
+}
+
+inline uint16_t exportGet16(const uint8_t* p) { return p[0] | (uint16_t)p[1] << 8; }
+inline uint32_t exportGet32(const uint8_t* p) { return exportGet16(p) | (uint32_t)exportGet16(p + 2) << 16; }
+
+// One "unixtime,id,confidence" line of /attendance.csv, without the newline
+inline bool exportParseLine(const char* line, ExportRecord& record) {
+    char* end;
+    unsigned long time = strtoul(line, &end, 10);
+    if (end == line || *end != ',') {
+        return false;
+    }
+    const char* field = end + 1;
+    unsigned long id = strtoul(field, &end, 10);
+    if (end == field || *end != ',' || id > 0xFFFF) {
+        return false;
+    }
+    field = end + 1;
+    unsigned long confidence = strtoul(field, &end, 10);
+    if (end == field || (*end != '\0' && *end != '\r') || confidence > 0xFFFF) {
+        return false;
+    }
+    record.time = time;
+    record.id = id;
+    record.confidence = confidence;
+    return true;
+}
+
+inline size_t exportWriteHeader(uint8_t* out) {
+    exportPut32(out, EXPORT_MAGIC);
+    out[4] = EXPORT_VERSION;
+    out[5] = 0;
+    exportPut16(out + 6, EXPORT_BLOCK_RECORDS);
+    return EXPORT_HEADER_LEN;
+}
+
+inline bool exportCheckHeader(const uint8_t* in) {
+    return exportGet32(in) == EXPORT_MAGIC && in[4] == EXPORT_VERSION &&
+           exportGet16(in + 6) > 0 && exportGet16(in + 6) <= EXPORT_BLOCK_RECORDS;
+}
+
+inline size_t exportSealBlock(uint8_t* out, uint16_t count, size_t payloadLen) {
+    exportPut16(out, count);
+    exportPut16(out + 2, payloadLen);
+    size_t len = 4 + payloadLen;
+    exportPut32(out + len, exportCrc32(0, out, len));
+    return len + 4;
+}
+
+// Encodes up to EXPORT_BLOCK_RECORDS records into out (EXPORT_BLOCK_MAX bytes)
+inline size_t exportEncodeBlock(uint8_t* out, const ExportRecord* records, uint16_t count) {
+    uint8_t* p = out + 4;
+    for (uint16_t i = 0; i < count; i++) {
+        uint32_t v = i == 0 ? records[0].time : exportZigzag((int32_t)(records[i].time - records[i - 1].time));
+        p += exportPutVarint(p, v);
+    }
+    for (uint16_t i = 0; i < count; i++) {
+        p += exportPutVarint(p, records[i].id);
+    }
+    for (uint16_t i = 0; i < count; i++) {
+        p += exportPutVarint(p, records[i].confidence);
+    }
+    return exportSealBlock(out, count, p - (out + 4));
+}
+
+inline size_t exportEncodeEnd(uint8_t* out, uint32_t exported, uint32_t skipped) {
+    uint8_t* p = out + 4;
+    p += exportPutVarint(p, exported);
+    p += exportPutVarint(p, skipped);
+    return exportSealBlock(out, 0, p - (out + 4));
+}
+
+// Decodes the block at in. records must hold EXPORT_BLOCK_RECORDS entries;
+// for the end block, exported/skipped receive the trailer counts.
+inline ExportStatus exportDecodeBlock(const uint8_t* in, size_t avail, ExportRecord* records, uint16_t& count,
+                                      size_t& used, uint32_t& exported, uint32_t& skipped) {
+    if (avail < EXPORT_BLOCK_OVERHEAD) {
+        return EXPORT_SHORT;
+    }
+    count = exportGet16(in);
+    size_t payloadLen = exportGet16(in + 2);
+    if (count > EXPORT_BLOCK_RECORDS || payloadLen > EXPORT_BLOCK_MAX - EXPORT_BLOCK_OVERHEAD) {
+        return EXPORT_BAD_BLOCK;
+    }
+    if (avail < payloadLen + EXPORT_BLOCK_OVERHEAD) {
+        return EXPORT_SHORT;
+    }
+    if (exportCrc32(0, in, 4 + payloadLen) != exportGet32(in + 4 + payloadLen)) {
+        return EXPORT_BAD_CRC;
+    }
+    used = payloadLen + EXPORT_BLOCK_OVERHEAD;
+
+    const uint8_t* p = in + 4;
+    const uint8_t* end = p + payloadLen;
+    uint32_t v;
+    if (count == 0) {
+        if (!exportGetVarint(p, end, exported) || !exportGetVarint(p, end, skipped) || p != end) {
+            return EXPORT_BAD_BLOCK;
+        }
+        return EXPORT_END;
+    }
+    for (uint16_t i = 0; i < count; i++) {
+        if (!exportGetVarint(p, end, v)) {
+            return EXPORT_BAD_BLOCK;
+        }
+        records[i].time = i == 0 ? v : records[i - 1].time + exportUnzigzag(v);
+    }
+    for (uint16_t i = 0; i < count; i++) {
+        if (!exportGetVarint(p, end, v) || v > 0xFFFF) {
+            return EXPORT_BAD_BLOCK;
+        }
+        records[i].id = v;
+    }
+    for (uint16_t i = 0; i < count; i++) {
+        if (!exportGetVarint(p, end, v) || v > 0xFFFF) {
+            return EXPORT_BAD_BLOCK;
+        }
+        records[i].confidence = v;
+    }
+    return p == end ? EXPORT_OK : EXPORT_BAD_BLOCK;
+}
@@ -4,9 +4,14 @@
 #include <LiquidCrystal_I2C.h>
 #include <RTClib.h>
 #include <Wire.h>
+#include "fingerprint_sensor.h"
 
-extern HardwareSerial mySerial;
-extern Adafruit_Fingerprint finger;
+// Reported on /status; override with -DFIRMWARE_VERSION=... in release builds
+#ifndef FIRMWARE_VERSION
+#define FIRMWARE_VERSION "1.0.0-dev"
+#endif
+
+extern FingerprintSensor sensors[SENSOR_COUNT];
 extern LiquidCrystal_I2C lcd;
 extern RTC_DS3231 rtc;
 // Removed rtcWire - now using default Wire for both LCD and RTC
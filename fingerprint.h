@@ -2,22 +2,50 @@
 #include "config.h"
 #include "display.h"
 #include "menu.h"
+#include "live_feed.h"
+#include "scan_cache.h"
+#include "attendance.h"
+#include "supervisor.h"
+#include "status_snapshot.h"
 
-bool awaitForFingerPlace(const String& str) {
+// Polls until getImage() returns `wanted`. Returns false when the supervisor
+// cancels the wait because it ran past its budget.
+bool waitForFinger(FingerprintSensor& sensor, uint8_t wanted) {
+    SupervisedScope scope(OP_FINGER_WAIT);
+    while (sensor.finger.getImage() != wanted) {
+        if (scope.cancelled()) {
+            Serial.println("Timeout waiting for finger");
+            return false;
+        }
+        handleLiveFeed();
+        delay(50);
+    }
+    return true;
+}
+
+bool awaitForFingerPlace(FingerprintSensor& sensor, const String& str) {
     lcdPrint(str, "Silahkan Letakkan jari Anda");
     Serial.println(str);
-    while (finger.getImage() != FINGERPRINT_OK) delay(100);
-    return true;
+    return waitForFinger(sensor, FINGERPRINT_OK);
 }
 
-bool awaitForFingerRemove(const String& str) {
+bool awaitForFingerRemove(FingerprintSensor& sensor, const String& str) {
     lcdPrint(str, "Silahkan Angkat Jari Anda");
     Serial.println(str);
-    while (finger.getImage() != FINGERPRINT_NOFINGER) delay(100);
-    return true;
+    return waitForFinger(sensor, FINGERPRINT_NOFINGER);
 }
 
-void testFingerDetection() {
+void showEnrollTimeout(int enrollID) {
+    lcdPrint("Timeout!", "Enroll dibatalkan");
+    Serial.println("Enrollment cancelled: no finger within budget");
+    liveFeedEnroll(enrollID, 0, "timeout");
+    delay(2000);
+    showMenu();
+}
+
+void testFingerDetection(FingerprintSensor& sensor) {
+    SensorLock guard(sensor);
+    Adafruit_Fingerprint& finger = sensor.finger;
     lcdPrint("Sanity test", "...");
     Serial.println("10s Max delay...");
 
@@ -28,6 +56,7 @@ void testFingerDetection() {
 
         if (p == FINGERPRINT_OK) {
             count++;
+            liveFeedScan(sensor.index, -1, 0, p);
             lcdPrint("OK!", "Count: " + String(count));
             Serial.println("\u2713 OK!");
             delay(500);
@@ -39,9 +68,12 @@ void testFingerDetection() {
             delay(100);
         } 
         else {
+            liveFeedScan(sensor.index, -1, 0, p);
             showError("err:", p);
             delay(100);
         }
+        
+        handleLiveFeed();
     }
 
     lcdPrint("complete!", "count: " + String(count));
@@ -51,7 +83,364 @@ void testFingerDetection() {
     showMenu();
 }
 
-int getNextID() {
+#define SCAN_PRECHECK_MAX 3
+#define SCAN_PRECHECK_MIN_CONFIDENCE 50
+#define SCAN_PRECHECK_MAX_AGE_S 5
+#define SCAN_POLL_MS 50
+#define SCAN_RESULT_QUEUE 8
+
+// Outcome of one scan on one sensor, produced by the sensor's scan task and
+// consumed by loop(), which owns the LCD and the attendance log.
+struct ScanResult {
+    uint8_t sensor;
+    int16_t id;           // -1 when nothing matched
+    uint16_t confidence;
+    uint8_t code;         // FINGERPRINT_* result of the failing step
+    bool precheck;        // matched through the recent-ID pre-check
+    uint16_t searchMs;
+};
+
+static QueueHandle_t scanResultQueue = nullptr;
+static volatile bool scanningEnabled = false;
+
+// Template sync between modules after enrollment, off by default
+bool sensorTemplateSync = false;
+
+// Match the captured image against the most recently recorded IDs only.
+// Costs a loadModel + match per candidate instead of a full search, so it is
+// only worth it for a repeat tap; older entries go straight to the search and
+// are still caught by scanCacheContains().
+int precheckRecentScan(FingerprintSensor& sensor, uint16_t& confidence) {
+    Adafruit_Fingerprint& finger = sensor.finger;
+    uint16_t recent[SCAN_PRECHECK_MAX];
+    int n = scanCacheRecent(recent, SCAN_PRECHECK_MAX, SCAN_PRECHECK_MAX_AGE_S);
+    if (n == 0) {
+        return -1;
+    }
+
+    // Live features go to slot 2, loadModel() always fills slot 1
+    if (finger.image2Tz(2) != FINGERPRINT_OK) {
+        return -1;
+    }
+
+    for (int i = 0; i < n; i++) {
+        if (finger.loadModel(recent[i]) != FINGERPRINT_OK) {
+            continue;
+        }
+        uint16_t score;
+        if (sensorMatchPrints(sensor, score) == FINGERPRINT_OK && score >= SCAN_PRECHECK_MIN_CONFIDENCE) {
+            confidence = score;
+            return recent[i];
+        }
+    }
+    return -1;
+}
+
+// One capture + identify pass. Returns false when there is nothing to report.
+bool scanSensorOnce(FingerprintSensor& sensor, ScanResult& result) {
+    Adafruit_Fingerprint& finger = sensor.finger;
+    uint8_t p = finger.getImage();
+
+    if (sensor.awaitLift) {
+        // Ignore the finger that produced the last result until it is lifted
+        if (p == FINGERPRINT_NOFINGER) {
+            sensor.awaitLift = false;
+        }
+        return false;
+    }
+
+    if (p == FINGERPRINT_NOFINGER) {
+        return false;
+    }
+    sensor.awaitLift = true;
+    SupervisedScope scope(OP_SCAN);
+
+    result.sensor = sensor.index;
+    result.id = -1;
+    result.confidence = 0;
+    result.code = p;
+    result.precheck = false;
+    result.searchMs = 0;
+
+    if (p != FINGERPRINT_OK) {
+        sensor.stats.errors++;
+        return true;
+    }
+
+    sensor.stats.scans++;
+    unsigned long start = millis();
+
+    uint16_t confidence = 0;
+    int id = precheckRecentScan(sensor, confidence);
+    if (id > 0) {
+        sensor.stats.precheckHits++;
+        result.precheck = true;
+    } else {
+        // The image buffer still holds the capture, regenerate slot 1 for search
+        unsigned long identifyStart = millis();
+        p = finger.image2Tz(1);
+        if (p == FINGERPRINT_OK) {
+            p = finger.fingerFastSearch();
+        }
+        if (p == FINGERPRINT_OK || p == FINGERPRINT_NOTFOUND) {
+            sensor.stats.identify.record(millis() - identifyStart);
+        }
+        if (p == FINGERPRINT_OK) {
+            id = finger.fingerID;
+            confidence = finger.confidence;
+        }
+    }
+
+    result.searchMs = millis() - start;
+    sensor.recordSearch(result.searchMs);
+    result.code = p;
+
+    if (p == FINGERPRINT_OK) {
+        sensor.stats.matches++;
+        result.id = id;
+        result.confidence = confidence;
+    } else if (p == FINGERPRINT_NOTFOUND) {
+        sensor.stats.noMatch++;
+    } else {
+        sensor.stats.errors++;
+    }
+    return true;
+}
+
+// One poll of the scan task; tools/replay calls it directly
+void scanTaskStep(FingerprintSensor& sensor) {
+    ScanResult result;
+
+    if (scanningEnabled && sensor.online) {
+        sensor.lock();
+        bool produced = scanSensorOnce(sensor, result);
+        sensor.unlock();
+
+        if (produced) {
+            liveFeedScan(result.sensor, result.id, result.confidence, result.code);
+            xQueueSend(scanResultQueue, &result, 0);
+        }
+    }
+}
+
+// Each sensor polls and searches in its own task, so readers on separate
+// UARTs work in parallel instead of queuing behind one another.
+void scanTask(void* arg) {
+    FingerprintSensor& sensor = *(FingerprintSensor*)arg;
+
+    for (;;) {
+        scanTaskStep(sensor);
+        vTaskDelay(pdMS_TO_TICKS(SCAN_POLL_MS));
+    }
+}
+
+void startScanTasks() {
+    scanResultQueue = xQueueCreate(SCAN_RESULT_QUEUE, sizeof(ScanResult));
+
+    for (int i = 0; i < SENSOR_COUNT; i++) {
+        char taskName[12];
+        snprintf(taskName, sizeof(taskName), "scan%d", i);
+        xTaskCreatePinnedToCore(scanTask, taskName, 4096, &sensors[i], 1, nullptr, 0);
+    }
+}
+
+void setScanningEnabled(bool enabled) {
+    scanningEnabled = enabled;
+}
+
+void showAlreadyRecorded(FingerprintSensor& sensor, uint16_t id) {
+    scanSuppressedCount++;
+    sensor.stats.suppressed++;
+    lcdPrint("Sudah tercatat", "ID #" + String(id));
+    Serial.println("Scan: ID #" + String(id) + " already recorded, suppressed");
+    printScanStats();
+}
+
+// Suppresses, logs and caches one identified finger, for the scan tasks and
+// 1:1 verification alike. Returns false when it was suppressed as a repeat.
+bool recordIdentifiedScan(FingerprintSensor& sensor, uint16_t id, uint16_t confidence, bool alreadySeen) {
+    statusNoteScan(sensor.index, id, confidence);
+
+    if (alreadySeen || scanCacheContains(id)) {
+        showAlreadyRecorded(sensor, id);
+        return false;
+    }
+
+    logAttendance(id, confidence);
+    scanCacheRecord(id);
+    return true;
+}
+
+// Drains scan results from the sensor tasks, called from loop()
+void handleScanResults() {
+    ScanResult result;
+
+    while (scanResultQueue != nullptr && xQueueReceive(scanResultQueue, &result, 0) == pdTRUE) {
+        FingerprintSensor& sensor = sensors[result.sensor];
+
+        if (result.id >= 0 || result.code == FINGERPRINT_NOTFOUND) {
+            scanCount++;
+        }
+
+        if (result.id < 0) {
+            if (result.code == FINGERPRINT_NOTFOUND) {
+                lcdPrint("Tidak dikenal", "Coba lagi");
+                Serial.println("Scan: no match on " + String(sensor.name));
+            } else {
+                showError("Scan fail:", result.code);
+            }
+            continue;
+        }
+
+        if (result.precheck) {
+            scanPrecheckHits++;
+        }
+        if (!recordIdentifiedScan(sensor, result.id, result.confidence, result.precheck)) {
+            continue;
+        }
+
+        lcdPrint("Hadir: ID #" + String(result.id), String(sensor.name) + " " + String(result.confidence));
+        Serial.println("Scan: ID #" + String(result.id) + " recorded on " + String(sensor.name) +
+                       ", confidence " + String(result.confidence) +
+                       ", " + String(result.searchMs) + "ms");
+    }
+}
+
+void printSensorStats() {
+    for (int i = 0; i < SENSOR_COUNT; i++) {
+        FingerprintSensor& sensor = sensors[i];
+        SensorStats& st = sensor.stats;
+        uint32_t avg = st.scans ? st.searchMsTotal / st.scans : 0;
+        Serial.println("Sensor " + String(i) + " (" + sensor.name + ")" +
+                       (sensor.online ? "" : " OFFLINE") +
+                       " scans: " + String(st.scans) +
+                       " match: " + String(st.matches) +
+                       " nomatch: " + String(st.noMatch) +
+                       " err: " + String(st.errors) +
+                       " precheck: " + String(st.precheckHits) +
+                       " suppressed: " + String(st.suppressed) +
+                       " search avg/max: " + String(avg) + "/" + String(st.searchMsMax) + "ms");
+    }
+}
+
+// 1:1 verification
+//
+// The operator enters the claimed ID first, so only that template is loaded
+// and compared against the live capture. Unlike a fast search the cost does
+// not grow with the database, and a stranger can only be accepted as the one
+// claimed ID rather than as the closest of all enrolled users.
+
+#define VERIFY_MIN_CONFIDENCE 80
+#define VERIFY_ATTEMPTS 3
+
+struct VerifyStats {
+    uint32_t attempts;
+    uint32_t accepted;
+    uint32_t rejected;
+    uint32_t lowConfidence;
+};
+
+VerifyStats verifyStats = {};
+
+// Features of the live finger go to slot 2, loadModel() fills slot 1
+uint8_t matchClaimedID(FingerprintSensor& sensor, uint16_t id, uint16_t& confidence) {
+    Adafruit_Fingerprint& finger = sensor.finger;
+    unsigned long start = millis();
+
+    uint8_t p = finger.image2Tz(2);
+    if (p == FINGERPRINT_OK) {
+        p = finger.loadModel(id);
+    }
+    if (p == FINGERPRINT_OK) {
+        p = sensorMatchPrints(sensor, confidence);
+    }
+    if (p == FINGERPRINT_OK || p == FINGERPRINT_NOMATCH) {
+        sensor.stats.verify.record(millis() - start);
+    }
+    return p;
+}
+
+// Returns FINGERPRINT_OK when the finger matches `id` with at least
+// VERIFY_MIN_CONFIDENCE, FINGERPRINT_NOMATCH when it does not
+uint8_t verifyClaimedID(FingerprintSensor& sensor, uint16_t id, uint16_t& confidence) {
+    SensorLock guard(sensor);
+    Adafruit_Fingerprint& finger = sensor.finger;
+    confidence = 0;
+
+    if (finger.loadModel(id) != FINGERPRINT_OK) {
+        return FINGERPRINT_BADLOCATION;
+    }
+
+    uint8_t p = FINGERPRINT_NOMATCH;
+    for (int attempt = 0; attempt < VERIFY_ATTEMPTS; attempt++) {
+        if (!awaitForFingerPlace(sensor, "Verifikasi #" + String(id))) {
+            return FINGERPRINT_TIMEOUT;
+        }
+
+        {
+            SupervisedScope scope(OP_SCAN);
+            verifyStats.attempts++;
+            p = matchClaimedID(sensor, id, confidence);
+        }
+
+        if (p == FINGERPRINT_OK && confidence < VERIFY_MIN_CONFIDENCE) {
+            verifyStats.lowConfidence++;
+            p = FINGERPRINT_NOMATCH;
+        }
+        if (p == FINGERPRINT_OK || p == FINGERPRINT_NOMATCH) {
+            break;
+        }
+
+        // Poor image, let the user try again
+        Serial.println("Verify capture failed (code " + String(p) + "), retrying");
+        if (!awaitForFingerRemove(sensor, "Coba lagi")) {
+            return FINGERPRINT_TIMEOUT;
+        }
+    }
+
+    if (p == FINGERPRINT_OK) {
+        verifyStats.accepted++;
+    } else if (p == FINGERPRINT_NOMATCH) {
+        verifyStats.rejected++;
+    }
+    Serial.println("Verify ID #" + String(id) + ": code " + String(p) + ", confidence " + String(confidence));
+    liveFeedScan(sensor.index, p == FINGERPRINT_OK ? id : -1, confidence, p);
+    return p;
+}
+
+// 1:N and 1:1 latency next to each other; 1:N grows with the template count
+void printMatchLatencyStats() {
+    for (int i = 0; i < SENSOR_COUNT; i++) {
+        const SensorStats& st = sensors[i].stats;
+        Serial.println("Sensor " + String(i) + " (" + String(sensors[i].templateCount) + " templates)" +
+                       " 1:N avg/max: " + String(st.identify.average()) + "/" + String(st.identify.msMax) + "ms" +
+                       " (" + String(st.identify.runs) + ")" +
+                       " | 1:1 avg/max: " + String(st.verify.average()) + "/" + String(st.verify.msMax) + "ms" +
+                       " (" + String(st.verify.runs) + ")");
+    }
+    Serial.println("Verify attempts: " + String(verifyStats.attempts) +
+                   " accepted: " + String(verifyStats.accepted) +
+                   " rejected: " + String(verifyStats.rejected) +
+                   " below " + String(VERIFY_MIN_CONFIDENCE) + ": " + String(verifyStats.lowConfidence));
+}
+
+// Copies a freshly enrolled template to the other sensors
+void syncTemplateToAll(FingerprintSensor& source, uint16_t id) {
+    for (int i = 0; i < SENSOR_COUNT; i++) {
+        FingerprintSensor& target = sensors[i];
+        if (&target == &source || !target.online) {
+            continue;
+        }
+
+        SensorLock guard(target);
+        bool ok = sensorCopyTemplate(source, target, id);
+        target.refreshTemplateCount();
+        Serial.println("Sync ID #" + String(id) + " to " + String(target.name) + (ok ? ": OK" : ": FAILED"));
+    }
+}
+
+int getNextID(FingerprintSensor& sensor) {
+    Adafruit_Fingerprint& finger = sensor.finger;
     lcdPrint("Scanning IDs...", "Mohon Tunggu...");
     Serial.println("lookup available ID slots...");
     
@@ -75,7 +464,8 @@ int getNextID() {
     return -1; 
 }
 
-int getEnrolledCount() {
+int getEnrolledCount(FingerprintSensor& sensor) {
+    Adafruit_Fingerprint& finger = sensor.finger;
     int count = 0;
     for (int i = 1; i <= 300; i++) {
         uint8_t p = finger.loadModel(i);
@@ -87,17 +477,21 @@ int getEnrolledCount() {
     return count;
 }
 
-void cleanSensorReading() {
+void cleanSensorReading(FingerprintSensor& sensor) {
+    Adafruit_Fingerprint& finger = sensor.finger;
     finger.getImage();
     delay(100);
 }
 
-void simpleEnrollment() {
+void simpleEnrollment(FingerprintSensor& sensor) {
+    SensorLock guard(sensor);
+    SupervisedScope scope(OP_ENROLL);
+    Adafruit_Fingerprint& finger = sensor.finger;
     lcdPrint("Enrolling", "Memulai...");
     Serial.println("Starting Enrollment");
     delay(1000);
 
-    int enrollID = getNextID();
+    int enrollID = getNextID(sensor);
     
     if (enrollID == -1) {
         lcdPrint("ERROR!", "No available slots");
@@ -107,18 +501,21 @@ void simpleEnrollment() {
         return;
     }
     
-    lcdPrint("ID: " + String(enrollID), "Total: " + String(getEnrolledCount()) + "/300");
+    lcdPrint("ID: " + String(enrollID), "Total: " + String(getEnrolledCount(sensor)) + "/300");
     Serial.println("Using ID #" + String(enrollID) + " for enrollment");
+    liveFeedEnroll(enrollID, 0, "started");
     delay(2000);
 
-    cleanSensorReading();
+    cleanSensorReading(sensor);
 
     showStep(1, "Letakan Jari Anda");
+    liveFeedEnroll(enrollID, 1, "place");
     lcdPrint("Step 1/5", "Tekan jari dengan");
     lcdPrintLine(1, "tekanan sedang");
     
-    while (finger.getImage() != FINGERPRINT_OK) {
-        delay(50);
+    if (!waitForFinger(sensor, FINGERPRINT_OK)) {
+        showEnrollTimeout(enrollID);
+        return;
     }
 
     lcdPrint("Fingerprint captured!", "Converting...");
@@ -127,6 +524,7 @@ void simpleEnrollment() {
     uint8_t p = finger.image2Tz(1);
     if (p != FINGERPRINT_OK) {
         showError("Image1 convert fail:", p);
+        liveFeedEnroll(enrollID, 1, "failed");
         delay(3000);
         showMenu();
         return;
@@ -137,8 +535,10 @@ void simpleEnrollment() {
     delay(1000);
 
     showStep(2, "Angkat jari Anda");
-    while (finger.getImage() != FINGERPRINT_NOFINGER) {
-        delay(50);
+    liveFeedEnroll(enrollID, 2, "remove");
+    if (!waitForFinger(sensor, FINGERPRINT_NOFINGER)) {
+        showEnrollTimeout(enrollID);
+        return;
     }
 
     lcdPrint("Jari diangkat", "Siap untuk step 3");
@@ -146,11 +546,13 @@ void simpleEnrollment() {
     delay(1000);
 
     showStep(3, "Letakkan sama persis");
+    liveFeedEnroll(enrollID, 3, "place");
     lcdPrint("Step 3/5", "Pastikan posisi");
     lcdPrintLine(1, "SAMA seperti tadi");
     
-    while (finger.getImage() != FINGERPRINT_OK) {
-        delay(50);
+    if (!waitForFinger(sensor, FINGERPRINT_OK)) {
+        showEnrollTimeout(enrollID);
+        return;
     }
 
     lcdPrint("Fingerprint captured!", "Converting...");
@@ -159,6 +561,7 @@ void simpleEnrollment() {
     p = finger.image2Tz(2);
     if (p != FINGERPRINT_OK) {
         showError("Image2 convert fail:", p);
+        liveFeedEnroll(enrollID, 3, "failed");
         delay(3000);
         showMenu();
         return;
@@ -169,6 +572,7 @@ void simpleEnrollment() {
     delay(1000);
 
     showStep(4, "Creating model...");
+    liveFeedEnroll(enrollID, 4, "model");
     Serial.println("Creating fingerprint model...");
     p = finger.createModel();
     
@@ -177,11 +581,13 @@ void simpleEnrollment() {
         lcdPrintLine(1, "match. Try again.");
         Serial.println("ERROR 11: FINGERPRINT_ENROLLMISMATCH - Images don't match well enough");
         Serial.println("Tips: Ensure same finger position, clean sensor, consistent pressure");
+        liveFeedEnroll(enrollID, 4, "mismatch");
         delay(4000);
         showMenu();
         return;
     } else if (p != FINGERPRINT_OK) {
         showError("Model creation fail:", p);
+        liveFeedEnroll(enrollID, 4, "failed");
         delay(3000);
         showMenu();
         return;
@@ -191,11 +597,19 @@ void simpleEnrollment() {
     Serial.println("\u2713 Model created successfully");
     delay(1000);
 
+    // Never store a template for an enrollment the supervisor already gave up on
+    if (scope.cancelled()) {
+        showEnrollTimeout(enrollID);
+        return;
+    }
+
     showStep(5, "Storing Template...");
+    liveFeedEnroll(enrollID, 5, "store");
     Serial.println("Storing to ID #" + String(enrollID) + "...");
     p = finger.storeModel(enrollID);
     if (p != FINGERPRINT_OK) {
         showError("Storage fail:", p);
+        liveFeedEnroll(enrollID, 5, "failed");
         delay(3000);
         showMenu();
         return;
@@ -204,7 +618,264 @@ void simpleEnrollment() {
     lcdPrint("SUCCESS!", "ID #" + String(enrollID));
     Serial.println("\u2713 Enrolled successfully to ID #" + String(enrollID));
     Serial.println("Enrollment complete!");
+    sensor.refreshTemplateCount();
+    
+    if (sensorTemplateSync) {
+        syncTemplateToAll(sensor, enrollID);
+    }
+    liveFeedEnroll(enrollID, 5, "done");
 
     delay(3000);
     showMenu();
-}
\ No newline at end of file
+}
+
+// Best-of-N enrollment
+//
+// The R30x has two character buffers, so "N captures" means: slot 1 holds a
+// reference capture and up to ENROLL_CAPTURES candidates are tried in slot 2
+// until createModel() accepts a pair. Captures that fail image2Tz() are
+// retaken on the spot, a mismatch only retakes the candidate (or the
+// reference after repeated mismatches), and the stored template is checked
+// with an immediate search before the enrollment counts as done.
+
+#define ENROLL_CAPTURES 4
+#define ENROLL_CAPTURE_RETRIES 3
+#define ENROLL_REFERENCE_MISMATCHES 2
+#define ENROLL_VERIFY_TRIES 2
+
+struct EnrollStats {
+    uint32_t started;
+    uint32_t completed;
+    uint32_t failed;
+    uint32_t captureRetries;
+    uint32_t mismatchRetries;
+    uint32_t verifyFailures;
+    uint32_t duplicates;
+    uint32_t totalMs;
+};
+
+EnrollStats enrollStats = {};
+
+void printEnrollStats() {
+    uint32_t avg = enrollStats.completed ? enrollStats.totalMs / enrollStats.completed : 0;
+    uint32_t runs = enrollStats.started ? enrollStats.started : 1;
+    Serial.println("Enroll started: " + String(enrollStats.started) +
+                   " done: " + String(enrollStats.completed) +
+                   " failed: " + String(enrollStats.failed) +
+                   " duplicate: " + String(enrollStats.duplicates) +
+                   " avg: " + String(avg / 1000.0, 1) + "s");
+    Serial.println("Retries per enrollment - capture: " + String((float)enrollStats.captureRetries / runs, 2) +
+                   " mismatch: " + String((float)enrollStats.mismatchRetries / runs, 2) +
+                   " verify: " + String((float)enrollStats.verifyFailures / runs, 2));
+}
+
+// Captures one image into `slot`, retaking it while image2Tz() rejects it
+uint8_t enrollCapture(FingerprintSensor& sensor, uint8_t slot, const String& prompt) {
+    Adafruit_Fingerprint& finger = sensor.finger;
+    uint8_t p = FINGERPRINT_IMAGEFAIL;
+
+    for (int attempt = 0; attempt <= ENROLL_CAPTURE_RETRIES; attempt++) {
+        if (!awaitForFingerPlace(sensor, prompt)) {
+            return FINGERPRINT_TIMEOUT;
+        }
+
+        p = finger.image2Tz(slot);
+        if (p == FINGERPRINT_OK) {
+            return p;
+        }
+
+        enrollStats.captureRetries++;
+        Serial.println("Capture rejected (code " + String(p) + "), retaking");
+        if (!awaitForFingerRemove(sensor, "Kualitas rendah")) {
+            return FINGERPRINT_TIMEOUT;
+        }
+    }
+    return p;
+}
+
+enum EnrollStoreResult {
+    ENROLL_STORED,
+    ENROLL_REJECTED,    // storing or the test search failed, worth a retry
+    ENROLL_DUPLICATE    // the finger is already enrolled as `existingID`
+};
+
+// Stores the model and checks it with a fresh capture and a full search.
+// The merged model is searched first, so a finger that is already enrolled
+// is reported as such instead of failing the test search over and over.
+EnrollStoreResult enrollStoreAndVerify(FingerprintSensor& sensor, int enrollID, int& existingID) {
+    Adafruit_Fingerprint& finger = sensor.finger;
+
+    if (finger.fingerSearch(1) == FINGERPRINT_OK) {
+        existingID = finger.fingerID;
+        return ENROLL_DUPLICATE;
+    }
+
+    uint8_t p = finger.storeModel(enrollID);
+    if (p != FINGERPRINT_OK) {
+        showError("Storage fail:", p);
+        return ENROLL_REJECTED;
+    }
+
+    for (int attempt = 0; attempt < ENROLL_VERIFY_TRIES && !supervisorLoopCancelled(); attempt++) {
+        if (!awaitForFingerRemove(sensor, "Verifikasi")) {
+            break;
+        }
+        liveFeedEnroll(enrollID, 5, "verify");
+        p = enrollCapture(sensor, 1, "Tes: letakkan");
+        if (p == FINGERPRINT_TIMEOUT) {
+            break;
+        } else if (p != FINGERPRINT_OK) {
+            continue;
+        }
+
+        p = finger.fingerSearch(1);
+        if (p == FINGERPRINT_OK && finger.fingerID == enrollID) {
+            Serial.println("\u2713 Verified ID #" + String(enrollID) + ", confidence " + String(finger.confidence));
+            return ENROLL_STORED;
+        }
+        if (p == FINGERPRINT_OK) {
+            // Closer to an older template than to the one just stored
+            existingID = finger.fingerID;
+            finger.deleteModel(enrollID);
+            return ENROLL_DUPLICATE;
+        }
+
+        enrollStats.verifyFailures++;
+        Serial.println("Verify failed (code " + String(p) + ", got ID " + String(finger.fingerID) + ")");
+    }
+
+    finger.deleteModel(enrollID);
+    return ENROLL_REJECTED;
+}
+
+void bestOfNEnrollment(FingerprintSensor& sensor) {
+    SensorLock guard(sensor);
+    SupervisedScope scope(OP_ENROLL);
+    Adafruit_Fingerprint& finger = sensor.finger;
+
+    unsigned long start = millis();
+    enrollStats.started++;
+
+    lcdPrint("Enrolling", "Best-of-" + String(ENROLL_CAPTURES));
+    Serial.println("Starting best-of-" + String(ENROLL_CAPTURES) + " enrollment");
+
+    // Slot scan happens once, retries below never repeat it
+    int enrollID = getNextID(sensor);
+    if (enrollID == -1) {
+        lcdPrint("ERROR!", "No available slots");
+        Serial.println("ERROR: No available ID slots (1-300 all occupied)");
+        enrollStats.failed++;
+        delay(3000);
+        showMenu();
+        return;
+    }
+
+    Serial.println("Using ID #" + String(enrollID) + " for enrollment");
+    liveFeedEnroll(enrollID, 0, "started");
+    cleanSensorReading(sensor);
+
+    bool stored = false;
+    int existingID = -1;
+    int mismatches = 0;
+    bool needReference = true;
+
+    // The finger waits below give up on their own once `scope` overruns
+    for (int candidate = 0; candidate < ENROLL_CAPTURES && !stored && !scope.cancelled(); candidate++) {
+        if (needReference) {
+            liveFeedEnroll(enrollID, 1, "place");
+            if (enrollCapture(sensor, 1, "Step 1: Letakkan") != FINGERPRINT_OK) {
+                break;
+            }
+            Serial.println("\u2713 Reference captured");
+            needReference = false;
+            mismatches = 0;
+        }
+
+        liveFeedEnroll(enrollID, 2, "remove");
+        if (!awaitForFingerRemove(sensor, "Angkat jari")) {
+            break;
+        }
+
+        liveFeedEnroll(enrollID, 3, "place");
+        if (enrollCapture(sensor, 2, "Step " + String(candidate + 2) + ": Lagi") != FINGERPRINT_OK) {
+            break;
+        }
+        Serial.println("\u2713 Candidate " + String(candidate + 1) + " captured");
+
+        liveFeedEnroll(enrollID, 4, "model");
+        uint8_t p = finger.createModel();
+
+        if (p == FINGERPRINT_ENROLLMISMATCH) {
+            // Keep the reference, only the candidate is retaken
+            enrollStats.mismatchRetries++;
+            mismatches++;
+            lcdPrint("Tidak cocok", "Ulangi posisi");
+            Serial.println("Mismatch on candidate " + String(candidate + 1));
+            liveFeedEnroll(enrollID, 4, "mismatch");
+
+            if (mismatches >= ENROLL_REFERENCE_MISMATCHES) {
+                Serial.println("Reference looks bad, retaking it");
+                if (!awaitForFingerRemove(sensor, "Mulai ulang")) {
+                    break;
+                }
+                needReference = true;
+            }
+            continue;
+        } else if (p != FINGERPRINT_OK) {
+            showError("Model creation fail:", p);
+            break;
+        }
+
+        Serial.println("\u2713 Model created");
+        liveFeedEnroll(enrollID, 5, "store");
+        EnrollStoreResult result = enrollStoreAndVerify(sensor, enrollID, existingID);
+        if (result == ENROLL_STORED) {
+            stored = true;
+        } else if (result == ENROLL_DUPLICATE) {
+            break;
+        } else {
+            // Template was rejected by the test search, start from a new reference
+            needReference = true;
+        }
+    }
+
+    if (existingID >= 0) {
+        enrollStats.failed++;
+        enrollStats.duplicates++;
+        lcdPrint("Sudah terdaftar", "ID #" + String(existingID));
+        Serial.println("Enrollment stopped: finger already enrolled as ID #" + String(existingID));
+        liveFeedEnroll(enrollID, 5, "duplicate");
+        printEnrollStats();
+        delay(3000);
+        showMenu();
+        return;
+    }
+
+    if (!stored) {
+        enrollStats.failed++;
+        lcdPrint("Enroll gagal", "ID #" + String(enrollID));
+        Serial.println("Enrollment failed for ID #" + String(enrollID));
+        liveFeedEnroll(enrollID, 5, "failed");
+        printEnrollStats();
+        delay(3000);
+        showMenu();
+        return;
+    }
+
+    unsigned long elapsed = millis() - start;
+    enrollStats.completed++;
+    enrollStats.totalMs += elapsed;
+
+    lcdPrint("SUCCESS!", "ID #" + String(enrollID));
+    Serial.println("\u2713 Enrolled ID #" + String(enrollID) + " in " + String(elapsed / 1000.0, 1) + "s");
+    printEnrollStats();
+    sensor.refreshTemplateCount();
+
+    if (sensorTemplateSync) {
+        syncTemplateToAll(sensor, enrollID);
+    }
+    liveFeedEnroll(enrollID, 5, "done");
+
+    delay(2000);
+    showMenu();
+}
@@ -0,0 +1,265 @@
+#pragma once
+#include <Arduino.h>
+#include <Adafruit_Fingerprint.h>
+#include "trace.h"
+
+// One fingerprint module on its own UART.
+//
+// Each sensor owns its HardwareSerial and Adafruit_Fingerprint instance, a
+// TraceStream between the two so replies end up in the input trace, a mutex
+// that serializes access between its scan task and foreground work (test,
+// enrollment, template sync), and its own statistics.
+
+// ESP32 has three UARTs. UART0 is the USB serial console, so two sensors are
+// the practical maximum; a third one on UART0 gives up the console.
+#define SENSOR_COUNT 1
+#define SENSOR_BAUD 57600
+#define SENSOR_TEMPLATE_MAX 1536
+
+// Latency of one matching mode, from feature extraction to the sensor's answer
+struct MatchTiming {
+    uint32_t runs;
+    uint32_t msTotal;
+    uint32_t msMax;
+
+    void record(uint32_t ms) {
+        runs++;
+        msTotal += ms;
+        if (ms > msMax) {
+            msMax = ms;
+        }
+    }
+    uint32_t average() const { return runs ? msTotal / runs : 0; }
+};
+
+struct SensorStats {
+    uint32_t scans;
+    uint32_t matches;
+    uint32_t noMatch;
+    uint32_t errors;
+    uint32_t precheckHits;
+    uint32_t suppressed;
+    uint32_t searchMsTotal;
+    uint32_t searchMsMax;
+    MatchTiming identify;   // 1:N, image2Tz + fingerFastSearch
+    MatchTiming verify;     // 1:1, image2Tz + loadModel + match
+};
+
+class FingerprintSensor {
+public:
+    FingerprintSensor(uint8_t index, int uart, int rxPin, int txPin, const char* name)
+        : index(index), name(name), uart(uart), rxPin(rxPin), txPin(txPin),
+          serial(uart), port(serial, index), finger(&port) {}
+
+    bool begin() {
+        if (mutex == nullptr) {
+            mutex = xSemaphoreCreateMutex();
+        }
+        serial.begin(SENSOR_BAUD, SERIAL_8N1, rxPin, txPin);
+        delay(100);
+
+        online = finger.verifyPassword();
+        if (online) {
+            finger.getParameters();
+            refreshTemplateCount();
+        }
+        return online;
+    }
+
+    // Caller holds the lock; cached so status reporting never touches the UART
+    void refreshTemplateCount() {
+        if (finger.getTemplateCount() == FINGERPRINT_OK) {
+            templateCount = finger.templateCount;
+        }
+    }
+
+    void lock() { xSemaphoreTake(mutex, portMAX_DELAY); }
+    void unlock() { xSemaphoreGive(mutex); }
+
+    void recordSearch(uint32_t ms) {
+        stats.searchMsTotal += ms;
+        if (ms > stats.searchMsMax) {
+            stats.searchMsMax = ms;
+        }
+    }
+
+    const uint8_t index;
+    const char* const name;
+    const int uart;
+    const int rxPin;
+    const int txPin;
+    HardwareSerial serial;
+    TraceStream port;
+    Adafruit_Fingerprint finger;
+    SensorStats stats = {};
+    uint16_t templateCount = 0;
+    bool online = false;
+    bool awaitLift = false;
+
+private:
+    SemaphoreHandle_t mutex = nullptr;
+};
+
+// Holds a sensor for the lifetime of a foreground operation
+class SensorLock {
+public:
+    explicit SensorLock(FingerprintSensor& sensor) : sensor(sensor) { sensor.lock(); }
+    ~SensorLock() { sensor.unlock(); }
+    SensorLock(const SensorLock&) = delete;
+    SensorLock& operator=(const SensorLock&) = delete;
+
+private:
+    FingerprintSensor& sensor;
+};
+
+// Raw R30x packets, used for template transfer where data packets are larger
+// than Adafruit_Fingerprint_Packet can hold.
+
+void sensorWritePacket(Stream& port, uint8_t pid, const uint8_t* data, uint16_t len) {
+    uint16_t wireLen = len + 2;
+    uint8_t header[9] = {
+        0xEF, 0x01, 0xFF, 0xFF, 0xFF, 0xFF,
+        pid, (uint8_t)(wireLen >> 8), (uint8_t)(wireLen & 0xFF)
+    };
+
+    uint16_t sum = pid + (wireLen >> 8) + (wireLen & 0xFF);
+    for (uint16_t i = 0; i < len; i++) {
+        sum += data[i];
+    }
+    uint8_t checksum[2] = { (uint8_t)(sum >> 8), (uint8_t)(sum & 0xFF) };
+
+    port.write(header, sizeof(header));
+    port.write(data, len);
+    port.write(checksum, sizeof(checksum));
+}
+
+// Returns the payload length, or -1 on timeout / bad packet
+int sensorReadPacket(Stream& port, uint8_t& pid, uint8_t* data, uint16_t maxLen, unsigned long timeout) {
+    uint8_t header[9];
+    uint16_t idx = 0;
+    uint16_t payloadLen = 0;
+    uint16_t sum = 0;
+    uint8_t checksumHigh = 0;
+    unsigned long start = millis();
+
+    while (millis() - start < timeout) {
+        if (!port.available()) {
+            delay(1);
+            continue;
+        }
+        uint8_t b = port.read();
+
+        if (idx < sizeof(header)) {
+            // Resynchronize on the start code
+            if ((idx == 0 && b != 0xEF) || (idx == 1 && b != 0x01)) {
+                idx = 0;
+                continue;
+            }
+            header[idx++] = b;
+            if (idx == sizeof(header)) {
+                pid = header[6];
+                uint16_t wireLen = ((uint16_t)header[7] << 8) | header[8];
+                if (wireLen < 2 || wireLen - 2 > maxLen) {
+                    return -1;
+                }
+                payloadLen = wireLen - 2;
+                sum = pid + header[7] + header[8];
+            }
+            continue;
+        }
+
+        uint16_t pos = idx - sizeof(header);
+        idx++;
+        if (pos < payloadLen) {
+            data[pos] = b;
+            sum += b;
+        } else if (pos == payloadLen) {
+            checksumHigh = b;
+        } else {
+            uint16_t checksum = ((uint16_t)checksumHigh << 8) | b;
+            return checksum == sum ? payloadLen : -1;
+        }
+    }
+    return -1;
+}
+
+// Reads the template in slot 1 out of the sensor. Returns its size or -1.
+int sensorUploadTemplate(FingerprintSensor& sensor, uint8_t* buffer, uint16_t maxLen) {
+    uint8_t cmd[2] = { FINGERPRINT_UPLOAD, 0x01 };
+    uint8_t reply[16];
+    uint8_t pid;
+
+    sensorWritePacket(sensor.port, FINGERPRINT_COMMANDPACKET, cmd, sizeof(cmd));
+    int len = sensorReadPacket(sensor.port, pid, reply, sizeof(reply), DEFAULTTIMEOUT);
+    if (len < 1 || pid != FINGERPRINT_ACKPACKET || reply[0] != FINGERPRINT_OK) {
+        return -1;
+    }
+
+    uint16_t total = 0;
+    do {
+        len = sensorReadPacket(sensor.port, pid, buffer + total, maxLen - total, DEFAULTTIMEOUT);
+        if (len < 0) {
+            return -1;
+        }
+        total += len;
+    } while (pid == FINGERPRINT_DATAPACKET);
+
+    return pid == FINGERPRINT_ENDDATAPACKET ? total : -1;
+}
+
+// Writes a template into slot 1 of the sensor
+bool sensorDownloadTemplate(FingerprintSensor& sensor, const uint8_t* buffer, uint16_t size) {
+    uint8_t cmd[2] = { 0x09, 0x01 };  // DownChar into slot 1
+    uint8_t reply[16];
+    uint8_t pid;
+
+    sensorWritePacket(sensor.port, FINGERPRINT_COMMANDPACKET, cmd, sizeof(cmd));
+    int len = sensorReadPacket(sensor.port, pid, reply, sizeof(reply), DEFAULTTIMEOUT);
+    if (len < 1 || pid != FINGERPRINT_ACKPACKET || reply[0] != FINGERPRINT_OK) {
+        return false;
+    }
+
+    uint16_t chunk = sensor.finger.packet_len ? sensor.finger.packet_len : 128;
+    for (uint16_t sent = 0; sent < size; sent += chunk) {
+        uint16_t n = min((uint16_t)(size - sent), chunk);
+        uint8_t type = sent + n >= size ? FINGERPRINT_ENDDATAPACKET : FINGERPRINT_DATAPACKET;
+        sensorWritePacket(sensor.port, type, buffer + sent, n);
+    }
+    return true;
+}
+
+// Compares the two character buffers (Match, 0x03). Adafruit_Fingerprint has
+// no wrapper for it. Returns the sensor's code and fills in the match score.
+uint8_t sensorMatchPrints(FingerprintSensor& sensor, uint16_t& score) {
+    uint8_t cmd[1] = { 0x03 };
+    uint8_t reply[16];
+    uint8_t pid;
+
+    score = 0;
+    sensorWritePacket(sensor.port, FINGERPRINT_COMMANDPACKET, cmd, sizeof(cmd));
+    int len = sensorReadPacket(sensor.port, pid, reply, sizeof(reply), DEFAULTTIMEOUT);
+    if (len < 1 || pid != FINGERPRINT_ACKPACKET) {
+        return FINGERPRINT_PACKETRECIEVEERR;
+    }
+    if (len >= 3) {
+        score = ((uint16_t)reply[1] << 8) | reply[2];
+    }
+    return reply[0];
+}
+
+// Copies template `id` from one sensor to another. Caller holds both locks.
+bool sensorCopyTemplate(FingerprintSensor& from, FingerprintSensor& to, uint16_t id) {
+    static uint8_t buffer[SENSOR_TEMPLATE_MAX];
+
+    if (from.finger.loadModel(id) != FINGERPRINT_OK) {
+        return false;
+    }
+    int len = sensorUploadTemplate(from, buffer, sizeof(buffer));
+    if (len <= 0) {
+        return false;
+    }
+    if (!sensorDownloadTemplate(to, buffer, len)) {
+        return false;
+    }
+    return to.finger.storeModel(id) == FINGERPRINT_OK;
+}
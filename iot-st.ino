@@ -6,10 +6,19 @@
 #include "rtc_helper.h"
 #include "buttons.h"
 #include "buttons_impl.h"
+#include "menu_items.h"
 
 // Device definitions
-HardwareSerial mySerial(2);
-Adafruit_Fingerprint finger(&mySerial);
+// Fingerprint sensors: index, UART, RX, TX, name
+FingerprintSensor sensors[SENSOR_COUNT] = {
+  {0, 2, 16, 17, "Masuk"},
+#if SENSOR_COUNT > 1
+  {1, 1, 32, 33, "Keluar"},
+#endif
+#if SENSOR_COUNT > 2
+  {2, 0, 3, 1, "Sensor 3"},
+#endif
+};
 LiquidCrystal_I2C lcd(0x27, 16, 2);
 RTC_DS3231 rtc;
 
@@ -40,6 +49,23 @@ const char* PARAM_INPUT_4 = "gateway";
 // Connection timeout
 const long connectionTimeout = 10000;
 
+// Sensor init attempts before giving up and restarting
+const int sensorInitRetries = 3;
+
+// Stage 2 recovery after an operation overran its budget
+void reinitHardware() {
+  lcd.init();
+  lcd.backlight();
+
+  for (int i = 0; i < SENSOR_COUNT; i++) {
+    SensorLock guard(sensors[i]);
+    SupervisedScope scope(OP_SENSOR_INIT);
+    bool online = sensors[i].begin();
+    Serial.println("Sensor " + String(i) + (online ? " re-initialized" : " still offline"));
+  }
+  showMenu();
+}
+
 void setup() {
   delay(2000);
   Serial.begin(9600);
@@ -54,6 +80,9 @@ void setup() {
   lcdPrint("Starting...", "");
   Serial.println("Hewwo");
 
+  // Record external inputs from here on
+  initTrace();
+
   // Initialize buttons
   lcdPrint("Init Buttons...", "");
   initButtons();
@@ -70,24 +99,41 @@ void setup() {
   initRTC();
   delay(1000);
 
-  mySerial.begin(57600, SERIAL_8N1, 16, 17);
-  delay(1000);
-
   lcdPrint("Checking sensor", "");
   Serial.println("Assessing Sensor status");
 
-  if (finger.verifyPassword()) {
-    lcdPrint("SENSOR OK!", "Max: " + String(finger.capacity));
-    Serial.println("SENSOR OK!");
-    finger.getParameters();
-    Serial.print("Max Templates: "); Serial.println(finger.capacity);
-    Serial.print("Security: "); Serial.println(finger.security_level);
-    delay(2000);
-  } else {
-    showError("No sensor found");
-    while (1) delay(1000);
+  for (int i = 0; i < SENSOR_COUNT; i++) {
+    FingerprintSensor& sensor = sensors[i];
+    bool online = false;
+
+    for (int attempt = 0; attempt < sensorInitRetries && !online; attempt++) {
+      SupervisedScope scope(OP_SENSOR_INIT);
+      online = sensor.begin();
+      if (!online) {
+        delay(1000);
+      }
+    }
+
+    if (online) {
+      lcdPrint("SENSOR " + String(i) + " OK!", "Max: " + String(sensor.finger.capacity));
+      Serial.println("SENSOR " + String(i) + " (" + sensor.name + ") OK!");
+      Serial.print("Max Templates: "); Serial.println(sensor.finger.capacity);
+      Serial.print("Security: "); Serial.println(sensor.finger.security_level);
+      delay(2000);
+    } else if (i == 0) {
+      showError("No sensor found");
+      Serial.println("Restarting in 10s");
+      delay(10000);
+      traceFlushAll();
+      ESP.restart();
+    } else {
+      showError("Sensor " + String(i) + " missing");
+      delay(2000);
+    }
   }
 
+  startScanTasks();
+
   lcdPrint("WiFi Setup", "Initializing...");
   
   if (initWiFiManager()) {
@@ -102,15 +148,36 @@ void setup() {
   
   // Show initial status screen
   lcdPrint(getTimeGreeting(), getCurrentTime());
+  initSupervisor();
+
   Serial.println("\n=== SYSTEM READY ===");
   Serial.println("Press any button to access menu");
-  Serial.println("Or use serial commands (1-6)");
+  Serial.println("Or type a menu number over serial");
 }
 
 void loop() {
+    // Loop heartbeat, recovery after overruns, scheduled restarts
+    supervisorTick(reinitHardware);
+    
     // Handle button interrupts
     handleButtons();
     
+    // Serial console, result screens and menu timeout
+    menuTick();
+    
+    // Push pending events to live feed clients
+    handleLiveFeed();
+    
+    // Rebuild the /status snapshot if anything it reports changed
+    handleStatusSnapshot();
+    
+    // Append recorded inputs to the trace file
+    handleTrace();
+    
+    // Sensors scan in their own tasks while the menu is closed
+    setScanningEnabled(!inMenu);
+    handleScanResults();
+    
     // Update display if not in menu
     if (!inMenu) {
         static unsigned long lastTimeUpdate = 0;
@@ -0,0 +1,272 @@
+#pragma once
+#include <Arduino.h>
+#include <WiFi.h>
+#include <ESPAsyncWebServer.h>
+
+// Live push channel for supervisor dashboards (Server-Sent Events on /events).
+//
+// Producers (scan, enrollment, menu, WiFi) only write into fixed slots here and
+// never touch the network. handleLiveFeed() runs from loop() and flushes the
+// pending events every LIVE_FEED_FLUSH_MS, so a burst of updates on one topic
+// collapses into the latest value. Scan results are discrete events and are
+// kept in a small ring instead of being coalesced.
+//
+// Each client gets at most LIVE_FEED_CLIENT_QUEUE packets waiting in its TCP
+// queue; a client that falls further behind is dropped so it cannot slow the
+// terminal or the other monitors down.
+
+#define LIVE_FEED_PATH "/events"
+#define LIVE_FEED_MAX_CLIENTS 12
+#define LIVE_FEED_CLIENT_QUEUE 8
+#define LIVE_FEED_FLUSH_MS 100
+#define LIVE_FEED_SCAN_SLOTS 8
+#define LIVE_FEED_PAYLOAD_LEN 96
+
+enum LiveTopic {
+    LIVE_ENROLL,
+    LIVE_MENU,
+    LIVE_WIFI,
+    LIVE_TOPIC_COUNT
+};
+
+static const char* const liveTopicNames[LIVE_TOPIC_COUNT] = {
+    "enroll",
+    "menu",
+    "wifi"
+};
+
+static AsyncEventSource liveEvents(LIVE_FEED_PATH);
+
+static portMUX_TYPE liveFeedMux = portMUX_INITIALIZER_UNLOCKED;
+// Recursive: closing a client under the lock runs liveOnDisconnect() at once
+static SemaphoreHandle_t liveClientLock = nullptr;
+
+// Pending state, written by producers under liveFeedMux
+static char liveTopicPayload[LIVE_TOPIC_COUNT][LIVE_FEED_PAYLOAD_LEN];
+static bool liveTopicDirty[LIVE_TOPIC_COUNT] = {false};
+static char liveScanRing[LIVE_FEED_SCAN_SLOTS][LIVE_FEED_PAYLOAD_LEN];
+static uint8_t liveScanHead = 0;
+static uint8_t liveScanCount = 0;
+
+// Connected clients, guarded by liveClientLock
+static AsyncEventSourceClient* liveClients[LIVE_FEED_MAX_CLIENTS] = {nullptr};
+
+static uint32_t liveEventId = 0;
+static unsigned long liveLastFlush = 0;
+
+// Statistics
+static uint32_t liveCoalesced = 0;
+static uint32_t liveScansDropped = 0;
+static uint32_t liveClientsDropped = 0;
+static uint32_t liveClientsRejected = 0;
+
+static void liveSetTopic(LiveTopic topic, const char* payload) {
+    portENTER_CRITICAL(&liveFeedMux);
+    if (liveTopicDirty[topic]) {
+        liveCoalesced++;
+    }
+    strncpy(liveTopicPayload[topic], payload, LIVE_FEED_PAYLOAD_LEN - 1);
+    liveTopicPayload[topic][LIVE_FEED_PAYLOAD_LEN - 1] = '\0';
+    liveTopicDirty[topic] = true;
+    portEXIT_CRITICAL(&liveFeedMux);
+}
+
+void liveFeedScan(int sensor, int id, int confidence, uint8_t code) {
+    char payload[LIVE_FEED_PAYLOAD_LEN];
+    snprintf(payload, sizeof(payload),
+             "{\"sensor\":%d,\"id\":%d,\"confidence\":%d,\"code\":%u,\"ms\":%lu}",
+             sensor, id, confidence, code, millis());
+
+    portENTER_CRITICAL(&liveFeedMux);
+    if (liveScanCount == LIVE_FEED_SCAN_SLOTS) {
+        // Ring full: overwrite the oldest scan
+        liveScanHead = (liveScanHead + 1) % LIVE_FEED_SCAN_SLOTS;
+        liveScanCount--;
+        liveScansDropped++;
+    }
+    uint8_t slot = (liveScanHead + liveScanCount) % LIVE_FEED_SCAN_SLOTS;
+    memcpy(liveScanRing[slot], payload, sizeof(payload));
+    liveScanCount++;
+    portEXIT_CRITICAL(&liveFeedMux);
+}
+
+void liveFeedEnroll(int id, int step, const char* state) {
+    char payload[LIVE_FEED_PAYLOAD_LEN];
+    snprintf(payload, sizeof(payload),
+             "{\"id\":%d,\"step\":%d,\"state\":\"%s\"}", id, step, state);
+    liveSetTopic(LIVE_ENROLL, payload);
+}
+
+void liveFeedMenu(bool active, int item, const char* label) {
+    char payload[LIVE_FEED_PAYLOAD_LEN];
+    snprintf(payload, sizeof(payload),
+             "{\"inMenu\":%s,\"item\":%d,\"label\":\"%s\"}",
+             active ? "true" : "false", item, label);
+    liveSetTopic(LIVE_MENU, payload);
+}
+
+void liveFeedWiFi(const char* state) {
+    char payload[LIVE_FEED_PAYLOAD_LEN];
+    snprintf(payload, sizeof(payload),
+             "{\"state\":\"%s\",\"ip\":\"%s\",\"rssi\":%d}",
+             state, WiFi.localIP().toString().c_str(), WiFi.RSSI());
+    liveSetTopic(LIVE_WIFI, payload);
+}
+
+// Runs in the WiFi event task
+void liveFeedWiFiEvent(arduino_event_id_t event, arduino_event_info_t info) {
+    switch (event) {
+        case ARDUINO_EVENT_WIFI_STA_GOT_IP:
+            liveFeedWiFi("connected");
+            break;
+        case ARDUINO_EVENT_WIFI_STA_DISCONNECTED:
+            liveFeedWiFi("disconnected");
+            break;
+        case ARDUINO_EVENT_WIFI_STA_LOST_IP:
+            liveFeedWiFi("lost_ip");
+            break;
+        default:
+            break;
+    }
+}
+
+// Runs in the async_tcp task
+static void liveOnConnect(AsyncEventSourceClient* client) {
+    bool accepted = false;
+
+    xSemaphoreTakeRecursive(liveClientLock, portMAX_DELAY);
+    for (int i = 0; i < LIVE_FEED_MAX_CLIENTS; i++) {
+        if (liveClients[i] == nullptr) {
+            liveClients[i] = client;
+            accepted = true;
+            break;
+        }
+    }
+    xSemaphoreGiveRecursive(liveClientLock);
+
+    if (!accepted) {
+        liveClientsRejected++;
+        client->close();
+        return;
+    }
+
+    // Bring the new monitor up to date with the last known state
+    portENTER_CRITICAL(&liveFeedMux);
+    char snapshot[LIVE_TOPIC_COUNT][LIVE_FEED_PAYLOAD_LEN];
+    memcpy(snapshot, liveTopicPayload, sizeof(snapshot));
+    portEXIT_CRITICAL(&liveFeedMux);
+
+    for (int t = 0; t < LIVE_TOPIC_COUNT; t++) {
+        if (snapshot[t][0] != '\0') {
+            client->send(snapshot[t], liveTopicNames[t], liveEventId);
+        }
+    }
+}
+
+static void liveOnDisconnect(AsyncEventSourceClient* client) {
+    xSemaphoreTakeRecursive(liveClientLock, portMAX_DELAY);
+    for (int i = 0; i < LIVE_FEED_MAX_CLIENTS; i++) {
+        if (liveClients[i] == client) {
+            liveClients[i] = nullptr;
+        }
+    }
+    xSemaphoreGiveRecursive(liveClientLock);
+}
+
+// Caller holds liveClientLock. Slow clients are closed while it is still
+// held, so a remote disconnect in async_tcp cannot free one in between.
+static void liveSendToClients(const char* payload, const char* event) {
+    liveEventId++;
+
+    for (int i = 0; i < LIVE_FEED_MAX_CLIENTS; i++) {
+        AsyncEventSourceClient* client = liveClients[i];
+        if (client == nullptr) {
+            continue;
+        }
+
+        if (client->packetsWaiting() >= LIVE_FEED_CLIENT_QUEUE) {
+            Serial.println("LiveFeed: dropping slow client");
+            liveClients[i] = nullptr;
+            liveClientsDropped++;
+            client->close();
+            continue;
+        }
+
+        client->send(payload, event, liveEventId);
+    }
+}
+
+void initLiveFeed(AsyncWebServer* server) {
+    if (liveClientLock == nullptr) {
+        liveClientLock = xSemaphoreCreateRecursiveMutex();
+    }
+
+    liveEvents.onConnect(liveOnConnect);
+    liveEvents.onDisconnect(liveOnDisconnect);
+    server->addHandler(&liveEvents);
+
+    Serial.println("LiveFeed: streaming on " LIVE_FEED_PATH);
+}
+
+void handleLiveFeed() {
+    if (liveClientLock == nullptr || millis() - liveLastFlush < LIVE_FEED_FLUSH_MS) {
+        return;
+    }
+    liveLastFlush = millis();
+
+    // Take everything pending in one short critical section
+    char topics[LIVE_TOPIC_COUNT][LIVE_FEED_PAYLOAD_LEN];
+    bool dirty[LIVE_TOPIC_COUNT];
+    char scans[LIVE_FEED_SCAN_SLOTS][LIVE_FEED_PAYLOAD_LEN];
+    uint8_t pendingScans;
+
+    portENTER_CRITICAL(&liveFeedMux);
+    for (int t = 0; t < LIVE_TOPIC_COUNT; t++) {
+        dirty[t] = liveTopicDirty[t];
+        if (dirty[t]) {
+            memcpy(topics[t], liveTopicPayload[t], LIVE_FEED_PAYLOAD_LEN);
+            liveTopicDirty[t] = false;
+        }
+    }
+    pendingScans = liveScanCount;
+    for (uint8_t i = 0; i < pendingScans; i++) {
+        memcpy(scans[i], liveScanRing[(liveScanHead + i) % LIVE_FEED_SCAN_SLOTS], LIVE_FEED_PAYLOAD_LEN);
+    }
+    liveScanHead = 0;
+    liveScanCount = 0;
+    portEXIT_CRITICAL(&liveFeedMux);
+
+    xSemaphoreTakeRecursive(liveClientLock, portMAX_DELAY);
+    for (uint8_t i = 0; i < pendingScans; i++) {
+        liveSendToClients(scans[i], "scan");
+    }
+    for (int t = 0; t < LIVE_TOPIC_COUNT; t++) {
+        if (dirty[t]) {
+            liveSendToClients(topics[t], liveTopicNames[t]);
+        }
+    }
+    xSemaphoreGiveRecursive(liveClientLock);
+}
+
+int getLiveFeedClientCount() {
+    int count = 0;
+    if (liveClientLock == nullptr) {
+        return 0;
+    }
+    xSemaphoreTakeRecursive(liveClientLock, portMAX_DELAY);
+    for (int i = 0; i < LIVE_FEED_MAX_CLIENTS; i++) {
+        if (liveClients[i] != nullptr) {
+            count++;
+        }
+    }
+    xSemaphoreGiveRecursive(liveClientLock);
+    return count;
+}
+
+void printLiveFeedStats() {
+    Serial.println("LiveFeed clients: " + String(getLiveFeedClientCount()) +
+                   " coalesced: " + String(liveCoalesced) +
+                   " scans dropped: " + String(liveScansDropped) +
+                   " slow clients dropped: " + String(liveClientsDropped) +
+                   " rejected: " + String(liveClientsRejected));
+}
@@ -1,17 +1,548 @@
 #pragma once
 #include "display.h"
 #include "rtc_helper.h"
+#include "live_feed.h"
+#include "supervisor.h"
+
+// Table-driven menu.
+//
+// The whole menu tree is a set of constexpr MenuPage/MenuItem tables (see
+// menu_items.h), so labels, handlers and submenu links live in flash and item
+// counts are derived from the arrays. One navigator drives both the LCD and
+// the serial console and never blocks: result screens and timeouts are
+// deadlines checked from menuTick().
+
+enum MenuFlags : uint8_t {
+    MENU_NONE = 0,
+    MENU_CONFIRM = 1 << 0,  // ask "Yakin?" before running the handler
+    MENU_BACK = 1 << 1      // return to the parent page
+};
+
+struct MenuPage;
+
+struct MenuItem {
+    const char* label;
+    void (*handler)();
+    const MenuPage* submenu;
+    uint8_t flags;
+    uint32_t budgetMs;      // supervisor budget for the handler, 0 = OP_MENU's
+};
+
+struct MenuPage {
+    const char* title;
+    const MenuItem* items;
+    uint8_t count;
+};
+
+template <size_t N>
+constexpr MenuPage makeMenuPage(const char* title, const MenuItem (&items)[N]) {
+    static_assert(N > 0 && N < 10, "menu pages hold 1-9 items (serial keys 1-9)");
+    return MenuPage{title, items, (uint8_t)N};
+}
+
+constexpr MenuItem menuAction(const char* label, void (*handler)(), uint8_t flags = MENU_NONE,
+                              uint32_t budgetMs = 0) {
+    return MenuItem{label, handler, nullptr, flags, budgetMs};
+}
+
+constexpr MenuItem menuSubmenu(const char* label, const MenuPage& page) {
+    return MenuItem{label, nullptr, &page, MENU_NONE, 0};
+}
+
+constexpr MenuItem menuBack() {
+    return MenuItem{"< Kembali", nullptr, nullptr, MENU_BACK, 0};
+}
+
+#define MENU_BUDGET_SLACK_MS 10000
+
+// Budget for a handler that runs `count` supervised `op`s back to back; the
+// enclosing menu operation must not cancel them before their own budget does
+constexpr uint32_t menuBudgetFor(SupervisedOp op, uint32_t count = 1) {
+    return opBudgets[op].budgetMs * count + MENU_BUDGET_SLACK_MS;
+}
+
+extern const MenuPage rootMenu;
+
+enum MenuKey {
+    MENU_KEY_LEFT,
+    MENU_KEY_RIGHT,
+    MENU_KEY_SELECT,
+    MENU_KEY_BACK
+};
+
+enum MenuMode {
+    MENU_MODE_BROWSE,
+    MENU_MODE_CONFIRM,
+    MENU_MODE_NUMBER,
+    MENU_MODE_RESULT
+};
+
+#define MENU_MAX_DEPTH 4
+#define MENU_TIMEOUT_MS 30000
+#define MENU_REFRESH_MS 10000
+
+int currentMenuItem = 0;
+bool inMenu = false;
+unsigned long lastButtonPress = 0;
+unsigned long lastMenuUpdate = 0;
+
+static const MenuPage* menuStack[MENU_MAX_DEPTH];
+static uint8_t menuStackItem[MENU_MAX_DEPTH];
+static uint8_t menuDepth = 0;
+static MenuMode menuMode = MENU_MODE_BROWSE;
+
+// What SELECT on the "Yakin?" screen runs. One slot for both kinds, so a
+// confirmation left behind by one flow can never fire in another.
+enum MenuPendingKind : uint8_t {
+    MENU_PENDING_NONE,
+    MENU_PENDING_ACTION,   // MENU_CONFIRM item, runs menuPendingAction
+    MENU_PENDING_NUMBER    // confirmed number entry, runs menuNumberApply
+};
+static MenuPendingKind menuPendingKind = MENU_PENDING_NONE;
+static void (*menuPendingAction)() = nullptr;
+
+// Number entry
+static const char* menuNumberTitle = "";
+static int menuNumberValue = 0;
+static int menuNumberMin = 0;
+static int menuNumberMax = 0;
+static int menuNumberStep = 1;
+static uint8_t menuNumberDigits = 0;     // digit-wise entry when non-zero
+static uint8_t menuNumberDigit = 0;      // digit being edited, 0 = leftmost, menuNumberDigits = OK/BATAL
+static int menuNumberInitial = 0;
+static bool menuNumberCancel = false;    // OK/BATAL choice after the last digit
+static bool menuNumberConfirm = false;   // entry asks "Yakin?" before applying
+static void (*menuNumberApply)(int) = nullptr;
+
+// Result screen
+static unsigned long menuResultUntil = 0;
+static uint32_t menuRenderCount = 0;
+
+// Serial console line buffer
+static char menuSerialLine[8];
+static uint8_t menuSerialLen = 0;
+
+static const MenuPage* menuPage() {
+    return menuStack[menuDepth];
+}
+
+static void menuPrintSerialPage() {
+    const MenuPage* page = menuPage();
+
+    Serial.println("\n=== " + String(page->title) + " ===");
+    Serial.println(getTimeGreeting() + " - " + getCurrentTime());
+    for (uint8_t i = 0; i < page->count; i++) {
+        Serial.print(i == currentMenuItem ? ">" : " ");
+        Serial.print(i + 1);
+        Serial.print(" - ");
+        Serial.println(page->items[i].label);
+    }
+    Serial.println("Enter number, 0 = back (or LEFT/RIGHT, SELECT)");
+}
+
+// Decimal digit `place` of the value being entered, 0 = ones
+static int menuNumberDigitAt(uint8_t place) {
+    int value = menuNumberValue;
+    for (uint8_t i = 0; i < place; i++) {
+        value /= 10;
+    }
+    return value % 10;
+}
+
+void menuRender(bool printPage = false) {
+    lastMenuUpdate = millis();
+    menuRenderCount++;
+
+    switch (menuMode) {
+        case MENU_MODE_BROWSE: {
+            const MenuPage* page = menuPage();
+            const MenuItem& item = page->items[currentMenuItem];
+            String line1 = ">" + String(item.label);
+            String line2 = "(" + String(currentMenuItem + 1) + "/" + String(page->count) + ") L<->R SEL";
+
+            if (line1.length() > 16) {
+                line1 = line1.substring(0, 15) + ">";
+            }
+
+            lcdPrint(line1, line2);
+            liveFeedMenu(true, currentMenuItem, item.label);
+
+            if (printPage) {
+                menuPrintSerialPage();
+            } else {
+                Serial.println("Selected: " + String(item.label));
+            }
+            break;
+        }
+
+        case MENU_MODE_CONFIRM:
+            lcdPrint("Yakin?", "SEL=ya L/R=batal");
+            Serial.println("Confirm " + String(menuPage()->items[currentMenuItem].label) + "? (y/n)");
+            break;
+
+        case MENU_MODE_NUMBER:
+            if (menuNumberDigits > 0) {
+                String digits;
+                for (int8_t i = menuNumberDigits - 1, pos = 0; i >= 0; i--, pos++) {
+                    char d = '0' + menuNumberDigitAt(i);
+                    digits += pos == menuNumberDigit ? "[" + String(d) + "]" : String(d);
+                }
+                if (menuNumberDigit < menuNumberDigits) {
+                    digits += "  SEL=>";
+                } else {
+                    digits += menuNumberCancel ? "  [BATAL]" : "  [OK]";
+                }
+                lcdPrint(menuNumberTitle, digits);
+            } else {
+                // Without a BACK button, SELECT on the unchanged value leaves
+                bool unchanged = menuNumberValue == menuNumberInitial;
+                lcdPrint(menuNumberTitle, "< " + String(menuNumberValue) + (unchanged ? " >  SEL=X" : " >  SEL=OK"));
+            }
+            Serial.println(String(menuNumberTitle) + ": " + String(menuNumberValue) +
+                           " (" + String(menuNumberMin) + "-" + String(menuNumberMax) +
+                           ", type a number or L/R, Enter=OK)");
+            break;
+
+        case MENU_MODE_RESULT:
+            break;
+    }
+}
+
+static void menuClearPending() {
+    menuPendingKind = MENU_PENDING_NONE;
+    menuPendingAction = nullptr;
+    menuNumberApply = nullptr;
+    menuNumberConfirm = false;
+}
 
 void showMenu() {
+    if (!inMenu) {
+        lcdPrint(getTimeGreeting(), getCurrentTime());
+        printRTCDebug();
+        return;
+    }
+    menuMode = MENU_MODE_BROWSE;
+    menuRender(true);
+}
+
+void menuEnter() {
+    inMenu = true;
+    menuDepth = 0;
+    menuStack[0] = &rootMenu;
+    currentMenuItem = 0;
+    menuMode = MENU_MODE_BROWSE;
+    menuClearPending();
+    lastButtonPress = millis();
+    menuRender(true);
+}
+
+void menuExit() {
+    inMenu = false;
+    menuMode = MENU_MODE_BROWSE;
+    menuClearPending();
+    liveFeedMenu(false, -1, "");
     lcdPrint(getTimeGreeting(), getCurrentTime());
-    
+    Serial.println("Menu closed - showing status screen");
     printRTCDebug();
-    
-    Serial.println("\nMenu:");
-    Serial.println("1 - Test finger detection");
-    Serial.println("2 - Simple enrollment test");
-    Serial.println("3 - WiFi status");
-    Serial.println("4 - Reset WiFi settings");
-    Serial.println("5 - Disconnect WiFi");
-    Serial.println("Enter command number:");
-}
\ No newline at end of file
+}
+
+// Shows a message and returns to the current page after `ms` without blocking
+void menuShowResult(const String& line1, const String& line2, unsigned long ms = 3000) {
+    lcdPrint(line1, line2);
+    Serial.println(line1 + " " + line2);
+    menuMode = MENU_MODE_RESULT;
+    menuResultUntil = millis() + ms;
+}
+
+static void menuStartNumber(const char* title, int minValue, int maxValue, int initial,
+                            void (*apply)(int), bool confirm, int step, uint8_t digits) {
+    menuNumberTitle = title;
+    menuNumberMin = minValue;
+    menuNumberMax = maxValue;
+    menuNumberStep = step;
+    menuNumberDigits = digits;
+    menuNumberDigit = 0;
+    menuNumberCancel = false;
+    menuNumberValue = constrain(initial, minValue, maxValue);
+    menuNumberInitial = menuNumberValue;
+    menuClearPending();
+    menuNumberApply = apply;
+    menuNumberConfirm = confirm;
+    menuMode = MENU_MODE_NUMBER;
+    menuRender();
+}
+
+// Starts number entry; `apply` runs with the chosen value on SELECT
+void menuPickNumber(const char* title, int minValue, int maxValue, int initial,
+                    void (*apply)(int), bool confirm = false, int step = 1) {
+    menuStartNumber(title, minValue, maxValue, initial, apply, confirm, step, 0);
+}
+
+// Number entry one digit at a time, for ranges too wide to step through
+// (template IDs go up to the sensor capacity). L/R change the digit under the
+// cursor, SELECT moves to the next one. After the last digit L/R pick OK or
+// BATAL and SELECT applies or leaves.
+void menuPickDigits(const char* title, int minValue, int maxValue, int initial,
+                    void (*apply)(int), bool confirm = false) {
+    uint8_t digits = 1;
+    for (int rest = maxValue; rest >= 10; rest /= 10) {
+        digits++;
+    }
+    menuStartNumber(title, minValue, maxValue, initial, apply, confirm, 1, digits);
+}
+
+static void menuRun(void (*handler)()) {
+    menuMode = MENU_MODE_BROWSE;
+    liveFeedMenu(true, currentMenuItem, menuPage()->items[currentMenuItem].label);
+    uint32_t renders = menuRenderCount;
+    {
+        SupervisedScope scope(OP_MENU, menuPage()->items[currentMenuItem].budgetMs);
+        handler();
+    }
+
+    // Handlers that did not redraw or switch screens land back on the page
+    if (inMenu && menuMode == MENU_MODE_BROWSE && menuRenderCount == renders) {
+        menuRender();
+    }
+    lastButtonPress = millis();
+}
+
+static void menuBackOut() {
+    if (menuDepth == 0) {
+        menuExit();
+        return;
+    }
+    menuDepth--;
+    currentMenuItem = menuStackItem[menuDepth];
+    menuRender(true);
+}
+
+static void menuActivate(uint8_t index) {
+    const MenuPage* page = menuPage();
+    if (index >= page->count) {
+        return;
+    }
+    currentMenuItem = index;
+    const MenuItem& item = page->items[index];
+
+    if (item.flags & MENU_BACK) {
+        menuBackOut();
+    } else if (item.submenu != nullptr) {
+        if (menuDepth + 1 < MENU_MAX_DEPTH) {
+            menuStackItem[menuDepth] = index;
+            menuStack[++menuDepth] = item.submenu;
+            currentMenuItem = 0;
+            menuRender(true);
+        }
+    } else if (item.handler != nullptr) {
+        if (item.flags & MENU_CONFIRM) {
+            menuClearPending();
+            menuPendingKind = MENU_PENDING_ACTION;
+            menuPendingAction = item.handler;
+            menuMode = MENU_MODE_CONFIRM;
+            menuRender();
+        } else {
+            menuRun(item.handler);
+        }
+    }
+}
+
+static void menuApplyNumber() {
+    void (*apply)(int) = menuNumberApply;
+    menuClearPending();
+    menuMode = MENU_MODE_BROWSE;
+    if (apply == nullptr) {
+        menuRender();
+        return;
+    }
+    {
+        // Number entry never leaves the item that started it
+        SupervisedScope scope(OP_MENU, menuPage()->items[currentMenuItem].budgetMs);
+        apply(menuNumberValue);
+    }
+    if (inMenu && menuMode == MENU_MODE_BROWSE) {
+        menuRender();
+    }
+}
+
+// Digit-wise entry can pass through values outside the range (e.g. 0000)
+static void menuSubmitNumber() {
+    menuNumberValue = constrain(menuNumberValue, menuNumberMin, menuNumberMax);
+    if (menuNumberConfirm) {
+        menuPendingKind = MENU_PENDING_NUMBER;
+        menuMode = MENU_MODE_CONFIRM;
+        menuRender();
+    } else {
+        menuApplyNumber();
+    }
+}
+
+void menuHandleKey(MenuKey key) {
+    lastButtonPress = millis();
+
+    if (!inMenu) {
+        menuEnter();
+        return;
+    }
+
+    switch (menuMode) {
+        case MENU_MODE_BROWSE: {
+            uint8_t count = menuPage()->count;
+            if (key == MENU_KEY_LEFT) {
+                currentMenuItem = (currentMenuItem - 1 + count) % count;
+                menuRender();
+            } else if (key == MENU_KEY_RIGHT) {
+                currentMenuItem = (currentMenuItem + 1) % count;
+                menuRender();
+            } else if (key == MENU_KEY_SELECT) {
+                menuActivate(currentMenuItem);
+            } else {
+                menuBackOut();
+            }
+            break;
+        }
+
+        case MENU_MODE_CONFIRM:
+            if (key == MENU_KEY_SELECT && menuPendingKind == MENU_PENDING_NUMBER) {
+                menuApplyNumber();
+            } else if (key == MENU_KEY_SELECT && menuPendingKind == MENU_PENDING_ACTION) {
+                void (*action)() = menuPendingAction;
+                menuClearPending();
+                menuRun(action);
+            } else {
+                menuClearPending();
+                menuMode = MENU_MODE_BROWSE;
+                Serial.println("Cancelled");
+                menuRender();
+            }
+            break;
+
+        case MENU_MODE_NUMBER:
+            if (menuNumberDigits > 0 && menuNumberDigit == menuNumberDigits &&
+                (key == MENU_KEY_LEFT || key == MENU_KEY_RIGHT)) {
+                menuNumberCancel = !menuNumberCancel;
+                menuRender();
+            } else if (menuNumberDigits > 0 && (key == MENU_KEY_LEFT || key == MENU_KEY_RIGHT)) {
+                int place = 1;
+                for (uint8_t i = menuNumberDigit + 1; i < menuNumberDigits; i++) {
+                    place *= 10;
+                }
+                int digit = menuNumberDigitAt(menuNumberDigits - 1 - menuNumberDigit);
+                int next = (digit + (key == MENU_KEY_RIGHT ? 1 : 9)) % 10;
+                menuNumberValue += (next - digit) * place;
+                menuRender();
+            } else if (key == MENU_KEY_LEFT) {
+                menuNumberValue = menuNumberValue > menuNumberMin
+                    ? max(menuNumberValue - menuNumberStep, menuNumberMin) : menuNumberMax;
+                menuRender();
+            } else if (key == MENU_KEY_RIGHT) {
+                menuNumberValue = menuNumberValue < menuNumberMax
+                    ? min(menuNumberValue + menuNumberStep, menuNumberMax) : menuNumberMin;
+                menuRender();
+            } else if (key == MENU_KEY_SELECT && menuNumberDigit < menuNumberDigits) {
+                menuNumberDigit++;
+                menuRender();
+            } else if (key == MENU_KEY_SELECT && !menuNumberCancel &&
+                       (menuNumberDigits > 0 || menuNumberValue != menuNumberInitial)) {
+                menuSubmitNumber();
+            } else {
+                menuClearPending();
+                menuMode = MENU_MODE_BROWSE;
+                Serial.println("Cancelled");
+                menuRender();
+            }
+            break;
+
+        case MENU_MODE_RESULT:
+            // Any key skips the result screen
+            menuMode = MENU_MODE_BROWSE;
+            menuRender();
+            break;
+    }
+}
+
+static void menuHandleSerialLine(const char* line) {
+    if (line[0] == '\0') {
+        // Bare Enter confirms number entry
+        if (inMenu && menuMode == MENU_MODE_NUMBER) {
+            lastButtonPress = millis();
+            menuSubmitNumber();
+        }
+        return;
+    }
+
+    if (!inMenu) {
+        menuEnter();
+        if (line[0] < '1' || line[0] > '9') {
+            return;
+        }
+    }
+    lastButtonPress = millis();
+
+    char c = line[0];
+    switch (menuMode) {
+        case MENU_MODE_BROWSE:
+        case MENU_MODE_RESULT:
+            menuMode = MENU_MODE_BROWSE;
+            if (c == '0' || c == 'b') {
+                menuBackOut();
+            } else if (c >= '1' && c <= '9') {
+                menuActivate(c - '1');
+            }
+            break;
+
+        case MENU_MODE_CONFIRM:
+            menuHandleKey(c == 'y' ? MENU_KEY_SELECT : MENU_KEY_BACK);
+            break;
+
+        case MENU_MODE_NUMBER:
+            if (c >= '0' && c <= '9') {
+                menuNumberValue = atoi(line);
+                menuSubmitNumber();
+            } else {
+                menuHandleKey(MENU_KEY_BACK);
+            }
+            break;
+    }
+}
+
+static void menuPollSerial() {
+    while (Serial.available()) {
+        char c = Serial.read();
+        traceConsoleByte(c);
+        if (c == '\r') {
+            continue;
+        }
+        if (c == '\n') {
+            menuSerialLine[menuSerialLen] = '\0';
+            menuSerialLen = 0;
+            menuHandleSerialLine(menuSerialLine);
+        } else if (menuSerialLen < sizeof(menuSerialLine) - 1) {
+            menuSerialLine[menuSerialLen++] = c;
+        }
+    }
+}
+
+// Called from loop(): serial input, result screens, timeouts
+void menuTick() {
+    menuPollSerial();
+
+    if (!inMenu) {
+        return;
+    }
+
+    if (menuMode == MENU_MODE_RESULT && (long)(millis() - menuResultUntil) >= 0) {
+        menuMode = MENU_MODE_BROWSE;
+        menuRender();
+    }
+
+    if (millis() - lastButtonPress > MENU_TIMEOUT_MS) {
+        Serial.println("Menu timeout");
+        menuExit();
+        return;
+    }
+
+    if (menuMode == MENU_MODE_BROWSE && millis() - lastMenuUpdate > MENU_REFRESH_MS) {
+        menuRender();
+    }
+}
@@ -0,0 +1,230 @@
+#pragma once
+#include "config.h"
+#include "menu.h"
+#include "fingerprint.h"
+#include "wifi_manager.h"
+#include "attendance.h"
+#include "attendance_export.h"
+#include "sensor_benchmark.h"
+
+// Menu handlers. Anything that only shows an outcome uses menuShowResult()
+// instead of delay(), so the navigator keeps running.
+
+void menuTestFinger() {
+    testFingerDetection(sensors[0]);
+}
+
+static int lastVerifyID = 1;
+
+void applyVerify(int id) {
+    lastVerifyID = id;
+    uint16_t confidence = 0;
+    uint8_t p = verifyClaimedID(sensors[0], id, confidence);
+
+    // Counted and suppressed like any other scan
+    if (p == FINGERPRINT_OK || p == FINGERPRINT_NOMATCH) {
+        scanCount++;
+    }
+
+    if (p == FINGERPRINT_OK) {
+        if (recordIdentifiedScan(sensors[0], id, confidence, false)) {
+            menuShowResult("Cocok: ID #" + String(id), "Skor " + String(confidence));
+        } else {
+            menuShowResult("Sudah tercatat", "ID #" + String(id));
+        }
+    } else if (p == FINGERPRINT_NOMATCH) {
+        menuShowResult("Tidak cocok", "ID #" + String(id));
+    } else if (p == FINGERPRINT_BADLOCATION) {
+        menuShowResult("ID #" + String(id), "Tidak terdaftar");
+    } else if (p == FINGERPRINT_TIMEOUT) {
+        menuShowResult("Timeout!", "Verifikasi batal");
+    } else {
+        menuShowResult("Verifikasi gagal", "Kode " + String(p));
+    }
+}
+
+// Claimed ID first (digit by digit with LEFT/RIGHT/SELECT), then a 1:1 match
+void menuVerify() {
+    menuPickDigits("Verifikasi ID", 1, sensors[0].finger.capacity, lastVerifyID, applyVerify);
+}
+
+void menuEnrollSimple() {
+    simpleEnrollment(sensors[0]);
+}
+
+void menuEnrollBestOfN() {
+    bestOfNEnrollment(sensors[0]);
+}
+
+void menuWiFiStatus() {
+    if (isWiFiConnected()) {
+        Serial.println("WiFi Status: Connected");
+        Serial.println("IP Address: " + getWiFiIP());
+        menuShowResult("WiFi Connected", getWiFiIP());
+    } else {
+        Serial.println("WiFi Status: Disconnected or in config mode");
+        menuShowResult("WiFi Disconnected", "Config mode active");
+    }
+}
+
+void menuResetWiFi() {
+    lcdPrint("Resetting WiFi", "Please wait...");
+    Serial.println("Resetting WiFi configuration...");
+    resetWiFiSettings();
+}
+
+void menuDisconnectWiFi() {
+    disconnectWiFi();
+    menuShowResult("Disconnecting", "WiFi...", 2000);
+}
+
+void menuSetRTC() {
+    Serial.println("Manual RTC time set (compile time)");
+    rtc.adjust(DateTime(F(__DATE__), F(__TIME__)));
+    menuShowResult("RTC Time Set", "To compile time", 2000);
+}
+
+void applyDeleteUser(int id) {
+    bool ok = true;
+
+    // Keep every module consistent, not just the primary one
+    for (int i = 0; i < SENSOR_COUNT; i++) {
+        if (!sensors[i].online) {
+            continue;
+        }
+        SensorLock guard(sensors[i]);
+        uint8_t p = sensors[i].finger.deleteModel(id);
+        if (p != FINGERPRINT_OK) {
+            Serial.println("Delete ID #" + String(id) + " on " + sensors[i].name + " failed, code " + String(p));
+            ok = false;
+        }
+        sensors[i].refreshTemplateCount();
+    }
+
+    menuShowResult(ok ? "User dihapus" : "Hapus gagal", "ID #" + String(id));
+}
+
+void menuDeleteUser() {
+    menuPickDigits("Hapus ID", 1, sensors[0].finger.capacity, 1, applyDeleteUser, true);
+}
+
+// The log goes out at 9600 baud, ~1KB/s; bigger logs use /attendance.bin
+#define MENU_EXPORT_LOG_BUDGET_MS (30UL * 60 * 1000)
+
+void menuExportLog() {
+    File file = LittleFS.open(ATTENDANCE_PATH, FILE_READ);
+    if (!file) {
+        menuShowResult("Export gagal", "Log kosong");
+        return;
+    }
+
+    lcdPrint("Export log", "via Serial...");
+    Serial.println("--- BEGIN " ATTENDANCE_PATH " ---");
+    uint8_t buffer[128];
+    size_t total = 0;
+    size_t n;
+    bool cut = false;
+    while ((n = file.read(buffer, sizeof(buffer))) > 0) {
+        // A log that outlasts MENU_EXPORT_LOG_BUDGET_MS is cut off
+        if (supervisorLoopCancelled()) {
+            cut = true;
+            break;
+        }
+        Serial.write(buffer, n);
+        total += n;
+    }
+    file.close();
+    Serial.println(cut ? "--- CUT, use " ATTENDANCE_EXPORT_PATH " ---" : "--- END ---");
+
+    menuShowResult(cut ? "Export terpotong" : "Export selesai", String(total) + " bytes");
+}
+
+void applySuppressWindow(int seconds) {
+    scanSuppressWindowSec = seconds;
+    menuShowResult("Jendela dup", String(seconds) + " detik", 2000);
+}
+
+void menuSuppressWindow() {
+    menuPickNumber("Jendela dup (s)", 0, 3600, scanSuppressWindowSec, applySuppressWindow, false, 10);
+}
+
+void menuToggleSync() {
+    sensorTemplateSync = !sensorTemplateSync;
+    menuShowResult("Sync template", sensorTemplateSync ? "ON" : "OFF", 2000);
+}
+
+void menuBenchmark() {
+    benchmarkSensorDrivers(sensors[0]);
+    menuShowResult("Benchmark selesai", "Lihat Serial", 4000);
+}
+
+void menuBenchExport() {
+    benchmarkAttendanceExport();
+    menuShowResult("Benchmark selesai", "Lihat Serial", 4000);
+}
+
+void menuToggleTrace() {
+    traceEnabled = !traceEnabled;
+    traceFlushAll();
+    menuShowResult("Input trace", traceEnabled ? "ON" : "OFF", 2000);
+}
+
+void menuStats() {
+    printScanStats();
+    printSensorStats();
+    printEnrollStats();
+    printMatchLatencyStats();
+    printLiveFeedStats();
+    printStatusStats();
+    printTraceStats();
+    printExportStats();
+    printSupervisorStats();
+    menuShowResult("Scan: " + String(scanCount), "Dup: " + String(scanSuppressedCount), 4000);
+}
+
+// Menu tree, leaves first so every page is defined before it is linked
+
+constexpr MenuItem enrollItems[] = {
+    menuAction("Enroll Cepat", menuEnrollSimple, MENU_NONE, menuBudgetFor(OP_ENROLL)),
+    menuAction("Enroll Best-of-N", menuEnrollBestOfN, MENU_NONE, menuBudgetFor(OP_ENROLL)),
+    menuBack()
+};
+constexpr MenuPage enrollMenu = makeMenuPage("Enroll", enrollItems);
+
+constexpr MenuItem wifiItems[] = {
+    menuAction("WiFi Status", menuWiFiStatus),
+    menuAction("Reset WiFi", menuResetWiFi, MENU_CONFIRM),
+    menuAction("Disconnect WiFi", menuDisconnectWiFi),
+    menuBack()
+};
+constexpr MenuPage wifiMenu = makeMenuPage("WiFi", wifiItems);
+
+constexpr MenuItem settingsItems[] = {
+    menuAction("Jendela Dup", menuSuppressWindow),
+    menuAction("Sync Template", menuToggleSync),
+    menuAction("Input Trace", menuToggleTrace),
+    menuAction("Set RTC Time", menuSetRTC, MENU_CONFIRM),
+    menuBack()
+};
+constexpr MenuPage settingsMenu = makeMenuPage("Settings", settingsItems);
+
+constexpr MenuItem adminItems[] = {
+    menuAction("Hapus User", menuDeleteUser),
+    menuAction("Export Log", menuExportLog, MENU_NONE, MENU_EXPORT_LOG_BUDGET_MS),
+    menuAction("Benchmark Sensor", menuBenchmark, MENU_NONE, menuBudgetFor(OP_BENCHMARK)),
+    menuAction("Bench Export", menuBenchExport, MENU_NONE, menuBudgetFor(OP_BENCHMARK)),
+    menuSubmenu("Settings", settingsMenu),
+    menuBack()
+};
+constexpr MenuPage adminMenu = makeMenuPage("Admin", adminItems);
+
+constexpr MenuItem rootItems[] = {
+    menuAction("Test Finger", menuTestFinger),
+    menuAction("Verifikasi 1:1", menuVerify, MENU_NONE, menuBudgetFor(OP_FINGER_WAIT, VERIFY_ATTEMPTS)),
+    menuSubmenu("Enroll Finger", enrollMenu),
+    menuSubmenu("WiFi", wifiMenu),
+    menuSubmenu("Admin", adminMenu),
+    menuAction("Statistik", menuStats),
+    menuBack()
+};
+constexpr MenuPage rootMenu = makeMenuPage("Menu", rootItems);
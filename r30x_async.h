@@ -0,0 +1,502 @@
+#pragma once
+#include <Arduino.h>
+#include <Adafruit_Fingerprint.h>
+#include <driver/uart.h>
+
+// Non-blocking R30x driver on the ESP-IDF UART driver.
+//
+// The UART driver fills its RX ring buffer from the ISR and posts UART_DATA
+// events; a reader task drains them into an incremental packet parser, so no
+// caller ever spins on Serial.available(). Commands are queued in a fixed pool
+// of R30X_PIPELINE_DEPTH requests: the next command goes out the moment the
+// previous acknowledgement is parsed, while the submitting task is free to
+// update the LCD, serve the network or write logs. Results come back through
+// an R30xFuture or a callback (run in the reader task, keep it short).
+//
+// The blocking methods (getImage(), image2Tz(), loadModel(), storeModel(), ...)
+// mirror Adafruit_Fingerprint, including fingerID/confidence/templateCount, so
+// existing call sites can switch drivers unchanged.
+//
+// The classic ESP32 UART has no general-purpose DMA; the driver's ISR + ring
+// buffer is the closest equivalent and keeps the CPU out of the byte loop.
+
+#define R30X_PIPELINE_DEPTH 8
+#define R30X_CMD_MAX 8
+#define R30X_MAX_PAYLOAD 32
+#define R30X_RX_BUFFER 512
+#define R30X_EVENT_QUEUE 16
+#define R30X_REPLY_TIMEOUT_MS 1000
+#define R30X_CMD_MATCH 0x03
+
+class R30xParser {
+public:
+    // Returns true once a complete packet with a valid checksum is parsed.
+    // Only the first R30X_MAX_PAYLOAD bytes of a larger packet are kept.
+    bool feed(uint8_t b) {
+        if (idx < 9) {
+            // Resynchronize on the start code
+            if ((idx == 0 && b != 0xEF) || (idx == 1 && b != 0x01)) {
+                idx = 0;
+                return false;
+            }
+            header[idx++] = b;
+            if (idx == 9) {
+                pid = header[6];
+                wireLen = ((uint16_t)header[7] << 8) | header[8];
+                if (wireLen < 2) {
+                    badPackets++;
+                    idx = 0;
+                    return false;
+                }
+                length = wireLen - 2;
+                sum = pid + header[7] + header[8];
+            }
+            return false;
+        }
+
+        uint16_t pos = idx - 9;
+        idx++;
+        if (pos < length) {
+            // Oversized (data) packets are checksummed but not stored
+            if (pos < R30X_MAX_PAYLOAD) {
+                payload[pos] = b;
+            }
+            sum += b;
+            return false;
+        }
+        if (pos == length) {
+            checksumHigh = b;
+            return false;
+        }
+
+        idx = 0;
+        uint16_t checksum = ((uint16_t)checksumHigh << 8) | b;
+        if (checksum != sum) {
+            badPackets++;
+            return false;
+        }
+        return true;
+    }
+
+    void reset() { idx = 0; }
+    bool truncated() const { return length > R30X_MAX_PAYLOAD; }
+
+    uint8_t pid = 0;
+    uint16_t length = 0;
+    uint8_t payload[R30X_MAX_PAYLOAD];
+    uint32_t badPackets = 0;
+
+private:
+    uint8_t header[9];
+    uint16_t idx = 0;
+    uint16_t wireLen = 0;
+    uint16_t sum = 0;
+    uint8_t checksumHigh = 0;
+};
+
+struct R30xRequest;
+typedef void (*R30xCallback)(const R30xRequest& request, void* arg);
+
+enum R30xState : uint8_t {
+    R30X_FREE,
+    R30X_QUEUED,
+    R30X_INFLIGHT,
+    R30X_DONE
+};
+
+struct R30xRequest {
+    volatile R30xState state;
+    uint8_t cmd[R30X_CMD_MAX];
+    uint8_t cmdLen;
+    uint8_t code;        // confirmation code, FINGERPRINT_TIMEOUT on no reply
+    uint16_t arg1;       // search: page ID, template count
+    uint16_t arg2;       // search / match: score
+    R30xCallback callback;
+    void* callbackArg;
+    TaskHandle_t waiter;
+    unsigned long sentAt;
+};
+
+class R30xAsyncDriver;
+
+// Handle to a queued command; get() waits for the reply and frees the slot
+class R30xFuture {
+public:
+    R30xFuture() : driver(nullptr), slot(-1) {}
+    R30xFuture(R30xAsyncDriver* driver, int slot) : driver(driver), slot(slot) {}
+
+    bool valid() const { return slot >= 0; }
+    bool ready() const;
+    // Default covers every request queued ahead timing out
+    uint8_t get(uint32_t timeoutMs = R30X_REPLY_TIMEOUT_MS * (R30X_PIPELINE_DEPTH + 1));
+
+    uint8_t code = FINGERPRINT_PACKETRECIEVEERR;
+    uint16_t arg1 = 0;
+    uint16_t arg2 = 0;
+
+private:
+    R30xAsyncDriver* driver;
+    int slot;
+};
+
+class R30xAsyncDriver {
+public:
+    R30xAsyncDriver(uart_port_t port, int rxPin, int txPin, uint16_t capacity = 0xA3)
+        : port(port), rxPin(rxPin), txPin(txPin), capacity(capacity) {}
+
+    bool begin(uint32_t baud = 57600) {
+        uart_config_t config = {};
+        config.baud_rate = baud;
+        config.data_bits = UART_DATA_8_BITS;
+        config.parity = UART_PARITY_DISABLE;
+        config.stop_bits = UART_STOP_BITS_1;
+        config.flow_ctrl = UART_HW_FLOWCTRL_DISABLE;
+#if ESP_ARDUINO_VERSION_MAJOR >= 3
+        config.source_clk = UART_SCLK_DEFAULT;
+#else
+        config.source_clk = UART_SCLK_APB;
+#endif
+
+        if (uart_driver_install(port, R30X_RX_BUFFER, 0, R30X_EVENT_QUEUE, &events, 0) != ESP_OK) {
+            return false;
+        }
+        uart_param_config(port, &config);
+        uart_set_pin(port, txPin, rxPin, UART_PIN_NO_CHANGE, UART_PIN_NO_CHANGE);
+        // Post UART_DATA after ~2 idle symbols so short acks arrive promptly
+        uart_set_rx_timeout(port, 2);
+
+        for (int i = 0; i < R30X_PIPELINE_DEPTH; i++) {
+            slots[i].state = R30X_FREE;
+        }
+        fifoHead = 0;
+        fifoCount = 0;
+        inflight = -1;
+        parser.reset();
+
+        running = true;
+        xTaskCreatePinnedToCore(readerTask, "r30x", 3072, this, 3, &reader, 0);
+        return true;
+    }
+
+    void end() {
+        running = false;
+        while (reader != nullptr) {
+            vTaskDelay(pdMS_TO_TICKS(5));
+        }
+        uart_driver_delete(port);
+    }
+
+    // Queues a raw command. Returns an invalid future when the pool is full.
+    R30xFuture submit(const uint8_t* cmd, uint8_t len, R30xCallback callback = nullptr, void* arg = nullptr) {
+        int slot = -1;
+        int send = -1;
+
+        portENTER_CRITICAL(&mux);
+        for (int i = 0; i < R30X_PIPELINE_DEPTH; i++) {
+            if (slots[i].state == R30X_FREE) {
+                slot = i;
+                break;
+            }
+        }
+        if (slot >= 0) {
+            R30xRequest& r = slots[slot];
+            memcpy(r.cmd, cmd, len);
+            r.cmdLen = len;
+            r.code = FINGERPRINT_PACKETRECIEVEERR;
+            r.arg1 = 0;
+            r.arg2 = 0;
+            r.callback = callback;
+            r.callbackArg = arg;
+            r.waiter = nullptr;
+            r.state = R30X_QUEUED;
+            fifo[(fifoHead + fifoCount) % R30X_PIPELINE_DEPTH] = slot;
+            fifoCount++;
+            send = startNextLocked();
+        }
+        portEXIT_CRITICAL(&mux);
+
+        if (send >= 0) {
+            transmit(send);
+        }
+        if (slot < 0) {
+            poolFull++;
+        }
+        return R30xFuture(callback ? nullptr : this, callback ? -1 : slot);
+    }
+
+    bool ready(int slot) const {
+        return slots[slot].state == R30X_DONE;
+    }
+
+    // Waits for the reply of `slot`, copies the result out and frees the slot
+    uint8_t wait(int slot, uint32_t timeoutMs, uint16_t& arg1, uint16_t& arg2) {
+        R30xRequest& r = slots[slot];
+        unsigned long start = millis();
+
+        portENTER_CRITICAL(&mux);
+        r.waiter = xTaskGetCurrentTaskHandle();
+        portEXIT_CRITICAL(&mux);
+
+        while (r.state != R30X_DONE && millis() - start < timeoutMs) {
+            ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(10));
+        }
+
+        portENTER_CRITICAL(&mux);
+        uint8_t code = r.state == R30X_DONE ? r.code : FINGERPRINT_TIMEOUT;
+        arg1 = r.arg1;
+        arg2 = r.arg2;
+        r.waiter = nullptr;
+        if (r.state == R30X_DONE) {
+            r.state = R30X_FREE;
+        } else {
+            // Still queued or in flight: let completion free it
+            r.callback = releaseCallback;
+        }
+        portEXIT_CRITICAL(&mux);
+        return code;
+    }
+
+    // Async commands, encoded like Adafruit_Fingerprint
+    R30xFuture getImageAsync(R30xCallback cb = nullptr, void* arg = nullptr) {
+        uint8_t cmd[] = {FINGERPRINT_GETIMAGE};
+        return submit(cmd, sizeof(cmd), cb, arg);
+    }
+    R30xFuture image2TzAsync(uint8_t slot = 1, R30xCallback cb = nullptr, void* arg = nullptr) {
+        uint8_t cmd[] = {FINGERPRINT_IMAGE2TZ, slot};
+        return submit(cmd, sizeof(cmd), cb, arg);
+    }
+    R30xFuture createModelAsync(R30xCallback cb = nullptr, void* arg = nullptr) {
+        uint8_t cmd[] = {FINGERPRINT_REGMODEL};
+        return submit(cmd, sizeof(cmd), cb, arg);
+    }
+    R30xFuture storeModelAsync(uint16_t id, R30xCallback cb = nullptr, void* arg = nullptr) {
+        uint8_t cmd[] = {FINGERPRINT_STORE, 0x01, (uint8_t)(id >> 8), (uint8_t)(id & 0xFF)};
+        return submit(cmd, sizeof(cmd), cb, arg);
+    }
+    R30xFuture loadModelAsync(uint16_t id, R30xCallback cb = nullptr, void* arg = nullptr) {
+        uint8_t cmd[] = {FINGERPRINT_LOAD, 0x01, (uint8_t)(id >> 8), (uint8_t)(id & 0xFF)};
+        return submit(cmd, sizeof(cmd), cb, arg);
+    }
+    R30xFuture deleteModelAsync(uint16_t id, R30xCallback cb = nullptr, void* arg = nullptr) {
+        uint8_t cmd[] = {FINGERPRINT_DELETE, (uint8_t)(id >> 8), (uint8_t)(id & 0xFF), 0x00, 0x01};
+        return submit(cmd, sizeof(cmd), cb, arg);
+    }
+    R30xFuture fingerFastSearchAsync(R30xCallback cb = nullptr, void* arg = nullptr) {
+        uint8_t cmd[] = {FINGERPRINT_HISPEEDSEARCH, 0x01, 0x00, 0x00,
+                         (uint8_t)(capacity >> 8), (uint8_t)(capacity & 0xFF)};
+        return submit(cmd, sizeof(cmd), cb, arg);
+    }
+    R30xFuture fingerSearchAsync(uint8_t slot = 1, R30xCallback cb = nullptr, void* arg = nullptr) {
+        uint8_t cmd[] = {FINGERPRINT_SEARCH, slot, 0x00, 0x00,
+                         (uint8_t)(capacity >> 8), (uint8_t)(capacity & 0xFF)};
+        return submit(cmd, sizeof(cmd), cb, arg);
+    }
+    R30xFuture matchPrintsAsync(R30xCallback cb = nullptr, void* arg = nullptr) {
+        uint8_t cmd[] = {R30X_CMD_MATCH};
+        return submit(cmd, sizeof(cmd), cb, arg);
+    }
+    R30xFuture getTemplateCountAsync(R30xCallback cb = nullptr, void* arg = nullptr) {
+        uint8_t cmd[] = {FINGERPRINT_TEMPLATECOUNT};
+        return submit(cmd, sizeof(cmd), cb, arg);
+    }
+
+    // Blocking equivalents of the Adafruit_Fingerprint calls
+    bool verifyPassword() {
+        uint8_t cmd[] = {FINGERPRINT_VERIFYPASSWORD, 0x00, 0x00, 0x00, 0x00};
+        return run(submit(cmd, sizeof(cmd))) == FINGERPRINT_OK;
+    }
+    uint8_t getImage() { return run(getImageAsync()); }
+    uint8_t image2Tz(uint8_t slot = 1) { return run(image2TzAsync(slot)); }
+    uint8_t createModel() { return run(createModelAsync()); }
+    uint8_t storeModel(uint16_t id) { return run(storeModelAsync(id)); }
+    uint8_t loadModel(uint16_t id) { return run(loadModelAsync(id)); }
+    uint8_t deleteModel(uint16_t id) { return run(deleteModelAsync(id)); }
+
+    uint8_t fingerFastSearch() { return runSearch(fingerFastSearchAsync()); }
+    uint8_t fingerSearch(uint8_t slot = 1) { return runSearch(fingerSearchAsync(slot)); }
+
+    uint8_t matchPrints() {
+        R30xFuture f = matchPrintsAsync();
+        uint8_t code = f.get();
+        confidence = f.arg1;
+        return code;
+    }
+
+    uint8_t getTemplateCount() {
+        R30xFuture f = getTemplateCountAsync();
+        uint8_t code = f.get();
+        templateCount = f.arg1;
+        return code;
+    }
+
+    uint16_t fingerID = 0;
+    uint16_t confidence = 0;
+    uint16_t templateCount = 0;
+
+    // Statistics
+    uint32_t packets = 0;
+    uint32_t timeouts = 0;
+    uint32_t overflows = 0;
+    uint32_t poolFull = 0;
+
+    uint32_t badPackets() const { return parser.badPackets; }
+
+private:
+    // Pops the next queued command if nothing is in flight. Caller holds mux.
+    int startNextLocked() {
+        if (inflight >= 0 || fifoCount == 0) {
+            return -1;
+        }
+        int slot = fifo[fifoHead];
+        fifoHead = (fifoHead + 1) % R30X_PIPELINE_DEPTH;
+        fifoCount--;
+        inflight = slot;
+        slots[slot].state = R30X_INFLIGHT;
+        slots[slot].sentAt = millis();
+        return slot;
+    }
+
+    void transmit(int slot) {
+        const R30xRequest& r = slots[slot];
+        uint16_t wireLen = r.cmdLen + 2;
+        uint8_t packet[9 + R30X_CMD_MAX + 2] = {
+            0xEF, 0x01, 0xFF, 0xFF, 0xFF, 0xFF, FINGERPRINT_COMMANDPACKET,
+            (uint8_t)(wireLen >> 8), (uint8_t)(wireLen & 0xFF)
+        };
+        uint16_t sum = FINGERPRINT_COMMANDPACKET + (wireLen >> 8) + (wireLen & 0xFF);
+        for (uint8_t i = 0; i < r.cmdLen; i++) {
+            packet[9 + i] = r.cmd[i];
+            sum += r.cmd[i];
+        }
+        packet[9 + r.cmdLen] = sum >> 8;
+        packet[10 + r.cmdLen] = sum & 0xFF;
+        uart_write_bytes(port, packet, 11 + r.cmdLen);
+    }
+
+    // Completes the in-flight request and starts the next one
+    void complete(uint8_t code, const uint8_t* data, uint16_t len) {
+        R30xCallback callback = nullptr;
+        void* callbackArg = nullptr;
+        TaskHandle_t waiter = nullptr;
+        int done;
+        int send;
+
+        portENTER_CRITICAL(&mux);
+        done = inflight;
+        if (done < 0) {
+            portEXIT_CRITICAL(&mux);
+            return;
+        }
+        R30xRequest& r = slots[done];
+        r.code = code;
+        r.arg1 = len >= 3 ? ((uint16_t)data[1] << 8) | data[2] : 0;
+        r.arg2 = len >= 5 ? ((uint16_t)data[3] << 8) | data[4] : 0;
+        r.state = R30X_DONE;
+        callback = r.callback;
+        callbackArg = r.callbackArg;
+        waiter = r.waiter;
+        inflight = -1;
+        send = startNextLocked();
+        portEXIT_CRITICAL(&mux);
+
+        // Keep the sensor busy before doing anything else
+        if (send >= 0) {
+            transmit(send);
+        }
+
+        if (callback != nullptr) {
+            callback(slots[done], callbackArg);
+            slots[done].state = R30X_FREE;
+        } else if (waiter != nullptr) {
+            xTaskNotifyGive(waiter);
+        }
+    }
+
+    static void releaseCallback(const R30xRequest&, void*) {}
+
+    static void readerTask(void* arg) {
+        R30xAsyncDriver* self = (R30xAsyncDriver*)arg;
+        uart_event_t event;
+        uint8_t buffer[64];
+
+        while (self->running) {
+            if (xQueueReceive(self->events, &event, pdMS_TO_TICKS(20)) == pdTRUE) {
+                if (event.type == UART_DATA) {
+                    size_t remaining = event.size;
+                    while (remaining > 0) {
+                        int n = uart_read_bytes(self->port, buffer, min(remaining, sizeof(buffer)), 0);
+                        if (n <= 0) {
+                            break;
+                        }
+                        remaining -= n;
+                        for (int i = 0; i < n; i++) {
+                            if (self->parser.feed(buffer[i]) && self->parser.pid == FINGERPRINT_ACKPACKET &&
+                                !self->parser.truncated()) {
+                                self->packets++;
+                                self->complete(self->parser.payload[0], self->parser.payload, self->parser.length);
+                            }
+                        }
+                    }
+                } else if (event.type == UART_FIFO_OVF || event.type == UART_BUFFER_FULL) {
+                    self->overflows++;
+                    uart_flush_input(self->port);
+                    xQueueReset(self->events);
+                    self->parser.reset();
+                    self->complete(FINGERPRINT_PACKETRECIEVEERR, nullptr, 0);
+                }
+            }
+
+            // Reply timeout for the in-flight command
+            int slot = self->inflight;
+            if (slot >= 0 && millis() - self->slots[slot].sentAt > R30X_REPLY_TIMEOUT_MS) {
+                self->timeouts++;
+                self->parser.reset();
+                self->complete(FINGERPRINT_TIMEOUT, nullptr, 0);
+            }
+        }
+
+        self->reader = nullptr;
+        vTaskDelete(nullptr);
+    }
+
+    uint8_t run(R30xFuture f) {
+        return f.get();
+    }
+
+    uint8_t runSearch(R30xFuture f) {
+        uint8_t code = f.get();
+        fingerID = f.arg1;
+        confidence = f.arg2;
+        return code;
+    }
+
+    const uart_port_t port;
+    const int rxPin;
+    const int txPin;
+    const uint16_t capacity;
+
+    QueueHandle_t events = nullptr;
+    TaskHandle_t reader = nullptr;
+    volatile bool running = false;
+    R30xParser parser;
+
+    portMUX_TYPE mux = portMUX_INITIALIZER_UNLOCKED;
+    R30xRequest slots[R30X_PIPELINE_DEPTH];
+    uint8_t fifo[R30X_PIPELINE_DEPTH];
+    uint8_t fifoHead = 0;
+    uint8_t fifoCount = 0;
+    volatile int inflight = -1;
+};
+
+inline bool R30xFuture::ready() const {
+    return driver != nullptr && slot >= 0 && driver->ready(slot);
+}
+
+inline uint8_t R30xFuture::get(uint32_t timeoutMs) {
+    if (driver == nullptr || slot < 0) {
+        return code;
+    }
+    code = driver->wait(slot, timeoutMs, arg1, arg2);
+    slot = -1;
+    return code;
+}
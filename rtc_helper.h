@@ -22,7 +22,7 @@ void initRTC() {
 }
 
 String getTimeGreeting() {
-    DateTime now = rtc.now();
+    DateTime now = rtcNow();
     int hour = now.hour();
     
     if (hour >= 5 && hour < 12) {
@@ -37,7 +37,7 @@ String getTimeGreeting() {
 }
 
 String getCurrentTime() {
-    DateTime now = rtc.now();
+    DateTime now = rtcNow();
     
     char timeStr[20];
     sprintf(timeStr, "%02d:%02d:%02d %02d/%02d", 
@@ -48,7 +48,7 @@ String getCurrentTime() {
 }
 
 void printRTCDebug() {
-    DateTime now = rtc.now();
+    DateTime now = rtcNow();
     
     Serial.print("RTC Time: ");
     Serial.print(now.year(), DEC);
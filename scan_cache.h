@@ -0,0 +1,145 @@
+#pragma once
+#include <Arduino.h>
+
+// Recent-ID cache for duplicate-scan suppression.
+//
+// Fixed table of (template ID, time bucket) pairs, 8 bytes per entry, no
+// allocation after boot. Buckets are SCAN_BUCKET_MS wide and stored as 32-bit
+// counters: entries are only expired when a finger is scanned, so one can sit
+// idle for days and its age must not alias. When millis() wraps (~49 days)
+// the age comes out huge, which expires the entry rather than suppressing.
+//
+// Read by the sensor scan tasks and written from loop(), so every access goes
+// through scanCacheMux.
+
+#define SCAN_CACHE_SIZE 16
+#define SCAN_BUCKET_MS 1000
+#define SCAN_SUPPRESS_WINDOW_S 60
+
+struct RecentScan {
+    uint16_t id;      // 0 = empty slot (templates start at 1)
+    uint32_t bucket;
+};
+
+static RecentScan scanCache[SCAN_CACHE_SIZE] = {};
+static portMUX_TYPE scanCacheMux = portMUX_INITIALIZER_UNLOCKED;
+
+// Suppression window in seconds, 0 disables suppression
+uint16_t scanSuppressWindowSec = SCAN_SUPPRESS_WINDOW_S;
+
+// Statistics
+uint32_t scanCount = 0;
+uint32_t scanSuppressedCount = 0;
+uint32_t scanPrecheckHits = 0;
+
+static inline uint32_t scanBucketNow() {
+    return millis() / SCAN_BUCKET_MS;
+}
+
+static inline uint32_t scanBucketAge(uint32_t bucket, uint32_t now) {
+    return now - bucket;
+}
+
+static void scanCacheExpireLocked() {
+    uint32_t now = scanBucketNow();
+    for (int i = 0; i < SCAN_CACHE_SIZE; i++) {
+        if (scanCache[i].id != 0 && scanBucketAge(scanCache[i].bucket, now) >= scanSuppressWindowSec) {
+            scanCache[i].id = 0;
+        }
+    }
+}
+
+bool scanCacheContains(uint16_t id) {
+    bool found = false;
+
+    portENTER_CRITICAL(&scanCacheMux);
+    scanCacheExpireLocked();
+    for (int i = 0; i < SCAN_CACHE_SIZE; i++) {
+        if (scanCache[i].id == id) {
+            found = true;
+            break;
+        }
+    }
+    portEXIT_CRITICAL(&scanCacheMux);
+    return found;
+}
+
+void scanCacheRecord(uint16_t id) {
+    if (scanSuppressWindowSec == 0) {
+        return;
+    }
+
+    portENTER_CRITICAL(&scanCacheMux);
+    uint32_t now = scanBucketNow();
+    int slot = 0;
+    uint32_t oldestAge = 0;
+
+    for (int i = 0; i < SCAN_CACHE_SIZE; i++) {
+        if (scanCache[i].id == id || scanCache[i].id == 0) {
+            slot = i;
+            break;
+        }
+        uint32_t age = scanBucketAge(scanCache[i].bucket, now);
+        if (age >= oldestAge) {
+            oldestAge = age;
+            slot = i;
+        }
+    }
+
+    scanCache[slot].id = id;
+    scanCache[slot].bucket = now;
+    portEXIT_CRITICAL(&scanCacheMux);
+}
+
+// Fills ids with up to max cached IDs seen within the last maxAgeSec seconds,
+// most recent first. Returns the count.
+int scanCacheRecent(uint16_t* ids, int max, uint32_t maxAgeSec) {
+    portENTER_CRITICAL(&scanCacheMux);
+    scanCacheExpireLocked();
+    uint32_t now = scanBucketNow();
+    uint32_t ages[SCAN_CACHE_SIZE];
+    int count = 0;
+
+    for (int i = 0; i < SCAN_CACHE_SIZE; i++) {
+        if (scanCache[i].id == 0) {
+            continue;
+        }
+
+        // Insertion sort by age into the small output array
+        uint32_t age = scanBucketAge(scanCache[i].bucket, now);
+        if (age > maxAgeSec) {
+            continue;
+        }
+        int pos = count;
+        while (pos > 0 && ages[pos - 1] > age) {
+            pos--;
+        }
+        if (pos >= max) {
+            continue;
+        }
+        if (count < max) {
+            count++;
+        }
+        for (int j = count - 1; j > pos; j--) {
+            ids[j] = ids[j - 1];
+            ages[j] = ages[j - 1];
+        }
+        ids[pos] = scanCache[i].id;
+        ages[pos] = age;
+    }
+    portEXIT_CRITICAL(&scanCacheMux);
+    return count;
+}
+
+void scanCacheClear() {
+    portENTER_CRITICAL(&scanCacheMux);
+    memset(scanCache, 0, sizeof(scanCache));
+    portEXIT_CRITICAL(&scanCacheMux);
+}
+
+void printScanStats() {
+    Serial.println("Scans: " + String(scanCount) +
+                   " suppressed: " + String(scanSuppressedCount) +
+                   " (precheck hits: " + String(scanPrecheckHits) + ")" +
+                   " window: " + String(scanSuppressWindowSec) + "s");
+}
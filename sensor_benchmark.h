@@ -0,0 +1,169 @@
+#pragma once
+#include "config.h"
+#include "display.h"
+#include "live_feed.h"
+#include "r30x_async.h"
+#include "supervisor.h"
+
+// Adafruit_Fingerprint (blocking) vs R30xAsyncDriver on the same sensor and
+// the same command mix. Every mode does the same fixed quantum of caller work
+// (LCD, network, log updates) after each command it submits, and measures how
+// long the caller sat blocked waiting for replies. Wall time minus blocked
+// time is what the calling task had left for everything else.
+
+#define BENCH_ROUNDS 20
+#define BENCH_WORK_QUANTUM 1
+
+struct BenchResult {
+    uint32_t ms;
+    uint32_t blockedUs;
+    uint32_t commands;
+    uint32_t errors;
+    uint32_t work;
+};
+
+static void benchWork(BenchResult& r) {
+    for (int i = 0; i < BENCH_WORK_QUANTUM; i++) {
+        handleLiveFeed();
+        r.work++;
+    }
+}
+
+// `since` is micros() from just before the caller started waiting on `code`
+static void benchCount(BenchResult& r, uint8_t code, unsigned long since) {
+    r.blockedUs += micros() - since;
+    r.commands++;
+    if (code == FINGERPRINT_TIMEOUT || code == FINGERPRINT_PACKETRECIEVEERR) {
+        r.errors++;
+    }
+}
+
+static uint32_t benchFreeMs(const BenchResult& r) {
+    uint32_t blockedMs = r.blockedUs / 1000;
+    return r.ms > blockedMs ? r.ms - blockedMs : 0;
+}
+
+static void printBenchResult(const char* label, const BenchResult& r) {
+    uint32_t perCommand = r.commands ? (r.ms * 1000) / r.commands : 0;
+    Serial.println(String(label) + ": " + String(r.ms) + "ms, " +
+                   String(r.commands) + " cmds, " +
+                   String(perCommand) + "us/cmd, " +
+                   String(r.errors) + " errors, " +
+                   String(r.work) + " work units, " +
+                   String(r.blockedUs / 1000) + "ms blocked, " +
+                   String(benchFreeMs(r)) + "ms caller-free");
+}
+
+BenchResult benchAdafruit(FingerprintSensor& sensor) {
+    BenchResult r = {};
+    unsigned long start = millis();
+    unsigned long t;
+
+    for (int i = 0; i < BENCH_ROUNDS; i++) {
+        t = micros();
+        benchCount(r, sensor.finger.getImage(), t);
+        benchWork(r);
+        t = micros();
+        benchCount(r, sensor.finger.loadModel(1), t);
+        benchWork(r);
+        t = micros();
+        benchCount(r, sensor.finger.getTemplateCount(), t);
+        benchWork(r);
+    }
+
+    r.ms = millis() - start;
+    return r;
+}
+
+BenchResult benchAsyncBlocking(R30xAsyncDriver& driver) {
+    BenchResult r = {};
+    unsigned long start = millis();
+    unsigned long t;
+
+    for (int i = 0; i < BENCH_ROUNDS; i++) {
+        t = micros();
+        benchCount(r, driver.getImage(), t);
+        benchWork(r);
+        t = micros();
+        benchCount(r, driver.loadModel(1), t);
+        benchWork(r);
+        t = micros();
+        benchCount(r, driver.getTemplateCount(), t);
+        benchWork(r);
+    }
+
+    r.ms = millis() - start;
+    return r;
+}
+
+// Replies come back in submission order, so the caller only ever waits on the
+// oldest request, and only once the pipeline is full or everything is out
+BenchResult benchAsyncPipelined(R30xAsyncDriver& driver) {
+    BenchResult r = {};
+    R30xFuture pending[R30X_PIPELINE_DEPTH];
+    int total = BENCH_ROUNDS * 3;
+    unsigned long start = millis();
+
+    for (int submitted = 0; submitted < total + R30X_PIPELINE_DEPTH; submitted++) {
+        R30xFuture& oldest = pending[submitted % R30X_PIPELINE_DEPTH];
+        if (oldest.valid()) {
+            unsigned long t = micros();
+            benchCount(r, oldest.get(), t);
+        }
+        if (submitted >= total) {
+            continue;
+        }
+
+        switch (submitted % 3) {
+            case 0: oldest = driver.getImageAsync(); break;
+            case 1: oldest = driver.loadModelAsync(1); break;
+            default: oldest = driver.getTemplateCountAsync(); break;
+        }
+        if (!oldest.valid()) {
+            benchCount(r, FINGERPRINT_PACKETRECIEVEERR, micros());
+        }
+        benchWork(r);
+    }
+
+    r.ms = millis() - start;
+    return r;
+}
+
+void benchmarkSensorDrivers(FingerprintSensor& sensor) {
+    SensorLock guard(sensor);
+    SupervisedScope supervised(OP_BENCHMARK);
+
+    lcdPrint("Benchmark", "Adafruit...");
+    Serial.println("=== Sensor driver benchmark, " + String(BENCH_ROUNDS) +
+                   " x (getImage, loadModel, getTemplateCount) ===");
+    BenchResult adafruit = benchAdafruit(sensor);
+    printBenchResult("Adafruit blocking", adafruit);
+
+    // Hand the UART over to the IDF driver for the async runs
+    sensor.serial.end();
+    R30xAsyncDriver driver((uart_port_t)sensor.uart, sensor.rxPin, sensor.txPin, sensor.finger.capacity);
+
+    if (driver.begin(SENSOR_BAUD)) {
+        lcdPrint("Benchmark", "Async...");
+        BenchResult blocking = benchAsyncBlocking(driver);
+        printBenchResult("Async blocking API", blocking);
+
+        BenchResult pipelined = benchAsyncPipelined(driver);
+        printBenchResult("Async pipelined", pipelined);
+
+        Serial.println("Parser: " + String(driver.packets) + " packets, " +
+                       String(driver.badPackets()) + " bad, " +
+                       String(driver.timeouts) + " timeouts, " +
+                       String(driver.overflows) + " overflows");
+        driver.end();
+
+        lcdPrint("A:" + String(adafruit.ms) + " P:" + String(pipelined.ms) + "ms",
+                 "Free " + String(benchFreeMs(adafruit)) + "/" + String(benchFreeMs(pipelined)) + "ms");
+    } else {
+        Serial.println("Async driver failed to install on UART " + String(sensor.uart));
+        lcdPrint("Benchmark", "Async init fail");
+    }
+
+    // Back to the Adafruit path used everywhere else
+    sensor.begin();
+}
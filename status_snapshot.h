@@ -0,0 +1,295 @@
+#pragma once
+#include <Arduino.h>
+#include <WiFi.h>
+#include <ESPAsyncWebServer.h>
+#include <stdarg.h>
+#include "config.h"
+#include "scan_cache.h"
+#include "supervisor.h"
+
+// Precomputed /status document.
+//
+// Fleet monitoring polls every device every few seconds, so the handler must
+// not query WiFi or format JSON per request. handleStatusSnapshot() runs from
+// loop(), gathers a small StatusKey from counters that are already maintained
+// elsewhere and only re-serializes when the key changed. The document is built
+// into the inactive half of a double buffer and published by flipping an index,
+// so the async_tcp task always serves a complete, stable buffer as-is.
+//
+// Every rebuild gets a new ETag; pollers sending If-None-Match get a bodiless
+// 304 until something actually changes.
+
+#define STATUS_PATH "/status"
+#define STATUS_JSON_MAX 1024
+#define STATUS_CHECK_MS 250
+#define STATUS_MIN_REBUILD_MS 1000
+#define STATUS_UPTIME_BUCKET_S 60
+
+// Everything the document depends on; a rebuild happens only when this changes
+struct StatusKey {
+    uint32_t networkGeneration;
+    uint32_t uptimeBucket;
+    uint32_t scans;
+    uint32_t suppressed;
+    uint32_t suppressWindow;
+    uint32_t overruns;
+    uint32_t lastScanGeneration;
+    uint32_t sensorScans[SENSOR_COUNT];
+    uint32_t sensorErrors[SENSOR_COUNT];
+    uint16_t sensorTemplates[SENSOR_COUNT];
+    bool sensorOnline[SENSOR_COUNT];
+};
+
+struct StatusBuffer {
+    char json[STATUS_JSON_MAX];
+    uint16_t len;
+    char etag[24];
+};
+
+static StatusBuffer statusBuffers[2];
+static volatile uint8_t statusActive = 0;
+static uint8_t statusReaders[2] = {0, 0};
+static portMUX_TYPE statusMux = portMUX_INITIALIZER_UNLOCKED;
+
+static StatusKey statusKey = {};
+static bool statusBuilt = false;
+static uint32_t statusBootId = 0;
+static uint32_t statusGeneration = 0;
+static unsigned long statusLastCheck = 0;
+static unsigned long statusLastBuild = 0;
+
+// Network state, refreshed only after a WiFi event
+static volatile uint32_t statusNetworkEvents = 1;
+static uint32_t statusNetworkSeen = 0;
+static bool statusConnected = false;
+static char statusIP[16] = "";
+static char statusSSID[33] = "";
+
+// Last identified finger, written from handleScanResults()
+static uint32_t statusLastScanGeneration = 0;
+static int statusLastScanSensor = -1;
+static uint16_t statusLastScanId = 0;
+static uint16_t statusLastScanConfidence = 0;
+static uint32_t statusLastScanTime = 0;
+
+// Statistics
+static uint32_t statusRebuilds = 0;
+static uint32_t statusServed = 0;
+static uint32_t statusNotModified = 0;
+static uint32_t statusDeferred = 0;
+static uint32_t statusTruncated = 0;
+
+// Runs in the WiFi event task
+void statusWiFiEvent(arduino_event_id_t event, arduino_event_info_t info) {
+    statusNetworkEvents++;
+}
+
+void statusNoteScan(int sensor, uint16_t id, uint16_t confidence) {
+    statusLastScanSensor = sensor;
+    statusLastScanId = id;
+    statusLastScanConfidence = confidence;
+    statusLastScanTime = rtcNow().unixtime();
+    statusLastScanGeneration++;
+}
+
+static void statusRefreshNetwork() {
+    statusConnected = WiFi.status() == WL_CONNECTED;
+    if (statusConnected) {
+        strncpy(statusIP, WiFi.localIP().toString().c_str(), sizeof(statusIP) - 1);
+        strncpy(statusSSID, WiFi.SSID().c_str(), sizeof(statusSSID) - 1);
+    } else {
+        statusIP[0] = '\0';
+        statusSSID[0] = '\0';
+    }
+}
+
+static StatusKey statusCurrentKey() {
+    StatusKey key = {};
+    key.networkGeneration = statusNetworkSeen;
+    key.uptimeBucket = millis() / 1000 / STATUS_UPTIME_BUCKET_S;
+    key.scans = scanCount;
+    key.suppressed = scanSuppressedCount;
+    key.suppressWindow = scanSuppressWindowSec;
+    key.overruns = supervisorOverrunTotal();
+    key.lastScanGeneration = statusLastScanGeneration;
+    for (int i = 0; i < SENSOR_COUNT; i++) {
+        key.sensorScans[i] = sensors[i].stats.scans;
+        key.sensorErrors[i] = sensors[i].stats.errors;
+        key.sensorTemplates[i] = sensors[i].templateCount;
+        key.sensorOnline[i] = sensors[i].online;
+    }
+    return key;
+}
+
+static bool statusAppend(StatusBuffer& buf, const char* format, ...) {
+    size_t room = sizeof(buf.json) - buf.len;
+    va_list args;
+    va_start(args, format);
+    int n = vsnprintf(buf.json + buf.len, room, format, args);
+    va_end(args);
+
+    if (n < 0 || (size_t)n >= room) {
+        buf.len = sizeof(buf.json) - 1;
+        return false;
+    }
+    buf.len += n;
+    return true;
+}
+
+// SSIDs are user data; keep the document valid JSON whatever they contain
+static void statusEscape(char* out, size_t outLen, const char* in) {
+    size_t o = 0;
+    for (; *in && o + 2 < outLen; in++) {
+        if (*in == '"' || *in == '\\') {
+            out[o++] = '\\';
+            out[o++] = *in;
+        } else if ((uint8_t)*in >= 0x20) {
+            out[o++] = *in;
+        }
+    }
+    out[o] = '\0';
+}
+
+static void statusBuild(StatusBuffer& buf, const StatusKey& key) {
+    char ssid[sizeof(statusSSID) * 2];
+    statusEscape(ssid, sizeof(ssid), statusSSID);
+
+    buf.len = 0;
+    bool ok = statusAppend(buf,
+        "{\"connected\":%s,\"ip\":\"%s\",\"ssid\":\"%s\","
+        "\"firmware\":\"" FIRMWARE_VERSION "\",\"build\":\"" __DATE__ " " __TIME__ "\","
+        "\"uptime_s\":%lu,\"enrolled\":%u,"
+        "\"scans\":%lu,\"suppressed\":%lu,\"suppress_window_s\":%lu,\"overruns\":%lu,",
+        statusConnected ? "true" : "false", statusIP, ssid,
+        (unsigned long)(key.uptimeBucket * STATUS_UPTIME_BUCKET_S), key.sensorTemplates[0],
+        (unsigned long)key.scans, (unsigned long)key.suppressed,
+        (unsigned long)key.suppressWindow, (unsigned long)key.overruns);
+
+    if (statusLastScanSensor >= 0) {
+        ok = ok && statusAppend(buf,
+            "\"last_scan\":{\"sensor\":%d,\"id\":%u,\"confidence\":%u,\"time\":%lu},",
+            statusLastScanSensor, statusLastScanId, statusLastScanConfidence,
+            (unsigned long)statusLastScanTime);
+    } else {
+        ok = ok && statusAppend(buf, "\"last_scan\":null,");
+    }
+
+    ok = ok && statusAppend(buf, "\"sensors\":[");
+    for (int i = 0; i < SENSOR_COUNT && ok; i++) {
+        const SensorStats& st = sensors[i].stats;
+        ok = statusAppend(buf,
+            "%s{\"name\":\"%s\",\"online\":%s,\"templates\":%u,\"scans\":%lu,"
+            "\"matches\":%lu,\"errors\":%lu,\"search_ms_max\":%lu}",
+            i ? "," : "", sensors[i].name, key.sensorOnline[i] ? "true" : "false",
+            key.sensorTemplates[i], (unsigned long)st.scans, (unsigned long)st.matches,
+            (unsigned long)st.errors, (unsigned long)st.searchMsMax);
+    }
+    ok = ok && statusAppend(buf, "]}");
+
+    if (!ok) {
+        // Never publish a cut-off document
+        statusTruncated++;
+        buf.len = 0;
+        statusAppend(buf, "{\"error\":\"status too large\"}");
+        Serial.println("Status: document exceeds " + String(STATUS_JSON_MAX) + " bytes");
+    }
+
+    statusGeneration++;
+    snprintf(buf.etag, sizeof(buf.etag), "\"%08lx-%lu\"",
+             (unsigned long)statusBootId, (unsigned long)statusGeneration);
+}
+
+// Runs in the async_tcp task
+static void statusRelease(uint8_t idx) {
+    portENTER_CRITICAL(&statusMux);
+    statusReaders[idx]--;
+    portEXIT_CRITICAL(&statusMux);
+}
+
+static void statusHandleRequest(AsyncWebServerRequest* request) {
+    portENTER_CRITICAL(&statusMux);
+    uint8_t idx = statusActive;
+    statusReaders[idx]++;
+    statusServed++;
+    portEXIT_CRITICAL(&statusMux);
+
+    const StatusBuffer& buf = statusBuffers[idx];
+    const AsyncWebHeader* match = request->getHeader("If-None-Match");
+    AsyncWebServerResponse* response;
+
+    if (match != nullptr && match->value() == buf.etag) {
+        response = request->beginResponse(304);
+        statusNotModified++;
+        response->addHeader("ETag", buf.etag);
+        response->addHeader("Cache-Control", "no-cache");
+        request->send(response);
+        statusRelease(idx);
+        return;
+    }
+
+    // Served straight from the buffer. The response only keeps a pointer and
+    // lwIP may ask for the body again later (small send window, retransmit),
+    // so the buffer stays pinned until the request is gone. A slow client
+    // delays the next rebuild instead of reading a half-written document.
+    response = request->beginResponse(200, "application/json", (const uint8_t*)buf.json, buf.len);
+    response->addHeader("ETag", buf.etag);
+    response->addHeader("Cache-Control", "no-cache");
+    request->onDisconnect([idx]() { statusRelease(idx); });
+    request->send(response);
+}
+
+void handleStatusSnapshot() {
+    unsigned long now = millis();
+    if (statusBuilt && now - statusLastCheck < STATUS_CHECK_MS) {
+        return;
+    }
+    statusLastCheck = now;
+
+    uint32_t events = statusNetworkEvents;
+    if (events != statusNetworkSeen) {
+        statusNetworkSeen = events;
+        statusRefreshNetwork();
+    }
+
+    StatusKey key = statusCurrentKey();
+    if (statusBuilt) {
+        if (memcmp(&key, &statusKey, sizeof(key)) == 0 || now - statusLastBuild < STATUS_MIN_REBUILD_MS) {
+            return;
+        }
+    }
+
+    uint8_t next = statusActive ^ 1;
+    portENTER_CRITICAL(&statusMux);
+    bool busy = statusReaders[next] != 0;
+    portEXIT_CRITICAL(&statusMux);
+    if (busy) {
+        // A request still holds the old buffer; try again on the next check
+        statusDeferred++;
+        return;
+    }
+
+    statusBuild(statusBuffers[next], key);
+    statusKey = key;
+    statusBuilt = true;
+    statusLastBuild = now;
+    statusRebuilds++;
+
+    portENTER_CRITICAL(&statusMux);
+    statusActive = next;
+    portEXIT_CRITICAL(&statusMux);
+}
+
+void initStatusSnapshot(AsyncWebServer* server) {
+    statusBootId = esp_random();
+    handleStatusSnapshot();
+    server->on(STATUS_PATH, HTTP_GET, statusHandleRequest);
+}
+
+void printStatusStats() {
+    Serial.println("Status served: " + String(statusServed) +
+                   " not modified: " + String(statusNotModified) +
+                   " rebuilds: " + String(statusRebuilds) +
+                   " deferred: " + String(statusDeferred) +
+                   " truncated: " + String(statusTruncated) +
+                   " size: " + String(statusBuffers[statusActive].len) + "B");
+}
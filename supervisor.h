@@ -0,0 +1,352 @@
+#pragma once
+#include <Arduino.h>
+#include <esp_task_wdt.h>
+#include "trace.h"
+
+// Health supervisor.
+//
+// Long-running operations register with superviseBegin() and get a deadline
+// from opBudgets[]. A supervisor task checks the open operations and only
+// feeds the ESP32 task watchdog while every one of them is within budget.
+// An overrun escalates in stages:
+//   1. cancel   - superviseCancelled() turns true, cooperative loops bail out
+//   2. re-init  - once the operation unwinds, loop() re-initializes the
+//                 sensors and the LCD (supervisorTick())
+//   3. restart  - if it is still stuck SUPERVISOR_RESTART_GRACE_MS later the
+//                 watchdog is starved and resets the chip
+// Every run is timed so the worst offenders show up in the stats.
+//
+// Operations opened from loop() nest (a menu handler runs an enrollment that
+// waits for a finger), so an overrun of an outer one cancels the inner ones
+// too. Time spent inside them is theirs: the loop heartbeat and the "loop"
+// stats only cover loop() outside any supervised operation.
+
+enum SupervisedOp {
+    OP_FINGER_WAIT,
+    OP_SCAN,
+    OP_ENROLL,
+    OP_SENSOR_INIT,
+    OP_WIFI_CONNECT,
+    OP_LOOP,
+    OP_BENCHMARK,
+    OP_MENU,
+    OP_COUNT
+};
+
+struct OpBudget {
+    const char* name;
+    uint32_t budgetMs;
+    bool reinitOnOverrun;
+};
+
+constexpr OpBudget opBudgets[OP_COUNT] = {
+    {"finger_wait", 30000, false},
+    {"scan", 3000, true},
+    {"enroll", 180000, true},
+    {"sensor_init", 5000, true},
+    {"wifi_connect", 15000, false},
+    {"loop", 5000, true},
+    {"benchmark", 120000, false},
+    {"menu", 70000, false}
+};
+
+#define SUPERVISOR_SLOTS 8
+#define SUPERVISOR_CHECK_MS 250
+#define SUPERVISOR_WDT_TIMEOUT_MS 8000
+#define SUPERVISOR_RESTART_GRACE_MS 10000
+#define SUPERVISOR_OFFENDERS 4
+
+struct SupervisorSlot {
+    bool active;
+    bool cancelled;
+    bool onLoop;
+    uint8_t op;
+    unsigned long start;
+    unsigned long deadline;
+};
+
+struct OpStats {
+    uint32_t runs;
+    uint32_t overruns;
+    uint32_t totalMs;
+    uint32_t worstMs;
+};
+
+struct Offender {
+    uint8_t op;
+    uint32_t ms;
+    uint32_t atSec;
+};
+
+static SupervisorSlot supervisorSlots[SUPERVISOR_SLOTS] = {};
+static portMUX_TYPE supervisorMux = portMUX_INITIALIZER_UNLOCKED;
+static TaskHandle_t supervisorTaskHandle = nullptr;
+static TaskHandle_t supervisorLoopTask = nullptr;
+
+OpStats opStats[OP_COUNT] = {};
+static Offender supervisorOffenders[SUPERVISOR_OFFENDERS] = {};
+static uint8_t supervisorOffenderCount = 0;
+
+static volatile bool supervisorReinitPending = false;
+static volatile bool supervisorStarving = false;
+static volatile unsigned long supervisorRestartAt = 0;
+static volatile unsigned long supervisorLoopBeat = 0;
+static uint8_t supervisorLoopDepth = 0;
+
+uint32_t supervisorOverrunTotal() {
+    uint32_t total = 0;
+    for (int i = 0; i < OP_COUNT; i++) {
+        total += opStats[i].overruns;
+    }
+    return total;
+}
+
+static void supervisorRecordOffender(uint8_t op, uint32_t ms) {
+    // Keep the slowest overruns seen so far
+    int slot = supervisorOffenderCount;
+    if (supervisorOffenderCount < SUPERVISOR_OFFENDERS) {
+        supervisorOffenderCount++;
+    } else {
+        slot = 0;
+        for (int i = 1; i < SUPERVISOR_OFFENDERS; i++) {
+            if (supervisorOffenders[i].ms < supervisorOffenders[slot].ms) {
+                slot = i;
+            }
+        }
+        if (supervisorOffenders[slot].ms >= ms) {
+            return;
+        }
+    }
+    supervisorOffenders[slot] = {op, ms, (uint32_t)(millis() / 1000)};
+}
+
+// Unsupervised time loop() spent since the last beat. Called with the mux held.
+static void supervisorLoopGap(unsigned long now) {
+    unsigned long gap = now - supervisorLoopBeat;
+    supervisorLoopBeat = now;
+
+    if (gap > opBudgets[OP_LOOP].budgetMs) {
+        OpStats& st = opStats[OP_LOOP];
+        st.overruns++;
+        if (gap > st.worstMs) {
+            st.worstMs = gap;
+        }
+        supervisorRecordOffender(OP_LOOP, gap);
+        if (opBudgets[OP_LOOP].reinitOnOverrun) {
+            supervisorReinitPending = true;
+        }
+    }
+}
+
+// Returns a handle for superviseEnd(), or -1 if every slot is busy.
+// `budgetMs` overrides the op's default budget when non-zero.
+int superviseBegin(SupervisedOp op, uint32_t budgetMs = 0) {
+    int handle = -1;
+    unsigned long now = millis();
+    bool onLoop = xTaskGetCurrentTaskHandle() == supervisorLoopTask;
+    if (budgetMs == 0) {
+        budgetMs = opBudgets[op].budgetMs;
+    }
+
+    portENTER_CRITICAL(&supervisorMux);
+    for (int i = 0; i < SUPERVISOR_SLOTS; i++) {
+        if (!supervisorSlots[i].active) {
+            supervisorSlots[i] = {true, false, onLoop, (uint8_t)op, now, now + budgetMs};
+            handle = i;
+            break;
+        }
+    }
+    if (handle >= 0 && onLoop && supervisorLoopDepth++ == 0) {
+        supervisorLoopGap(now);
+    }
+    portEXIT_CRITICAL(&supervisorMux);
+    return handle;
+}
+
+static bool supervisorSlotExpired(const SupervisorSlot& slot, unsigned long now) {
+    return slot.cancelled || (long)(now - slot.deadline) > 0;
+}
+
+// True once an operation open on loop() overran. They all enclose each other,
+// so this is also how code inside a menu handler sees the handler's budget.
+bool supervisorLoopCancelled() {
+    unsigned long now = millis();
+    for (int i = 0; i < SUPERVISOR_SLOTS; i++) {
+        const SupervisorSlot& slot = supervisorSlots[i];
+        if (slot.active && slot.onLoop && supervisorSlotExpired(slot, now)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool superviseCancelled(int handle) {
+    if (handle < 0) {
+        return false;
+    }
+    const SupervisorSlot& slot = supervisorSlots[handle];
+    return slot.onLoop ? supervisorLoopCancelled() : supervisorSlotExpired(slot, millis());
+}
+
+
+void superviseEnd(int handle) {
+    if (handle < 0) {
+        return;
+    }
+
+    portENTER_CRITICAL(&supervisorMux);
+    SupervisorSlot slot = supervisorSlots[handle];
+    supervisorSlots[handle].active = false;
+
+    unsigned long now = millis();
+    uint32_t ms = now - slot.start;
+    if (slot.onLoop && --supervisorLoopDepth == 0) {
+        supervisorLoopBeat = now;
+    }
+    bool overrun = ms > slot.deadline - slot.start;
+    OpStats& st = opStats[slot.op];
+    st.runs++;
+    st.totalMs += ms;
+    if (ms > st.worstMs) {
+        st.worstMs = ms;
+    }
+    if (overrun) {
+        st.overruns++;
+        supervisorRecordOffender(slot.op, ms);
+        if (opBudgets[slot.op].reinitOnOverrun) {
+            supervisorReinitPending = true;
+        }
+    }
+    portEXIT_CRITICAL(&supervisorMux);
+
+    if (overrun) {
+        Serial.println("Supervisor: " + String(opBudgets[slot.op].name) + " overran budget, took " + String(ms) + "ms");
+    }
+}
+
+// Scoped form of superviseBegin()/superviseEnd()
+class SupervisedScope {
+public:
+    explicit SupervisedScope(SupervisedOp op, uint32_t budgetMs = 0) : handle(superviseBegin(op, budgetMs)) {}
+    ~SupervisedScope() { superviseEnd(handle); }
+    bool cancelled() const { return superviseCancelled(handle); }
+    SupervisedScope(const SupervisedScope&) = delete;
+    SupervisedScope& operator=(const SupervisedScope&) = delete;
+
+private:
+    const int handle;
+};
+
+// Restart from loop() instead of blocking the caller (e.g. an async handler)
+void supervisorScheduleRestart(unsigned long delayMs) {
+    supervisorRestartAt = millis() + delayMs;
+    if (supervisorRestartAt == 0) {
+        supervisorRestartAt = 1;
+    }
+}
+
+static void supervisorTask(void* arg) {
+    esp_task_wdt_add(nullptr);
+
+    for (;;) {
+        unsigned long now = millis();
+        bool healthy = true;
+        bool loopBusy = false;
+
+        portENTER_CRITICAL(&supervisorMux);
+        for (int i = 0; i < SUPERVISOR_SLOTS; i++) {
+            SupervisorSlot& slot = supervisorSlots[i];
+            if (!slot.active) {
+                continue;
+            }
+            if (slot.onLoop) {
+                loopBusy = true;
+            }
+
+            long late = (long)(now - slot.deadline);
+            if (late > 0 && !slot.cancelled) {
+                slot.cancelled = true;  // stage 1
+            }
+            if (late > (long)SUPERVISOR_RESTART_GRACE_MS) {
+                healthy = false;        // stage 3
+            }
+        }
+        portEXIT_CRITICAL(&supervisorMux);
+
+        // loop() must keep beating unless it is inside a supervised operation
+        if (!loopBusy && supervisorLoopBeat != 0 &&
+            now - supervisorLoopBeat > opBudgets[OP_LOOP].budgetMs + SUPERVISOR_RESTART_GRACE_MS) {
+            healthy = false;
+        }
+
+        if (healthy) {
+            esp_task_wdt_reset();
+        } else if (!supervisorStarving) {
+            supervisorStarving = true;
+            Serial.println("Supervisor: operation stuck past grace period, starving watchdog");
+        }
+
+        vTaskDelay(pdMS_TO_TICKS(SUPERVISOR_CHECK_MS));
+    }
+}
+
+void initSupervisor() {
+#if ESP_ARDUINO_VERSION_MAJOR >= 3
+    esp_task_wdt_config_t config = {
+        .timeout_ms = SUPERVISOR_WDT_TIMEOUT_MS,
+        .idle_core_mask = 0,
+        .trigger_panic = true
+    };
+    if (esp_task_wdt_init(&config) == ESP_ERR_INVALID_STATE) {
+        esp_task_wdt_reconfigure(&config);
+    }
+#else
+    esp_task_wdt_init(SUPERVISOR_WDT_TIMEOUT_MS / 1000, true);
+#endif
+
+    supervisorLoopTask = xTaskGetCurrentTaskHandle();
+    supervisorLoopBeat = millis();
+    xTaskCreatePinnedToCore(supervisorTask, "supervisor", 3072, nullptr, 2, &supervisorTaskHandle, 0);
+    Serial.println("Supervisor: watchdog " + String(SUPERVISOR_WDT_TIMEOUT_MS) + "ms");
+}
+
+// Called from loop(). `reinit` performs stage 2 recovery (sensors, LCD).
+void supervisorTick(void (*reinit)()) {
+    unsigned long now = millis();
+    portENTER_CRITICAL(&supervisorMux);
+    supervisorLoopGap(now);
+    portEXIT_CRITICAL(&supervisorMux);
+
+    if (supervisorReinitPending) {
+        supervisorReinitPending = false;
+        Serial.println("Supervisor: re-initializing sensors and LCD after overrun");
+        reinit();
+    }
+
+    if (supervisorRestartAt != 0 && (long)(now - supervisorRestartAt) >= 0) {
+        Serial.println("Supervisor: scheduled restart");
+        traceFlushAll();
+        delay(100);
+        ESP.restart();
+    }
+}
+
+void printSupervisorStats() {
+    for (int i = 0; i < OP_COUNT; i++) {
+        const OpStats& st = opStats[i];
+        if (st.runs == 0 && st.overruns == 0) {
+            continue;
+        }
+        uint32_t avg = st.runs ? st.totalMs / st.runs : 0;
+        Serial.println("Op " + String(opBudgets[i].name) +
+                       " runs: " + String(st.runs) +
+                       " overruns: " + String(st.overruns) +
+                       " avg/worst: " + String(avg) + "/" + String(st.worstMs) + "ms" +
+                       " budget: " + String(opBudgets[i].budgetMs) + "ms");
+    }
+    for (int i = 0; i < supervisorOffenderCount; i++) {
+        const Offender& o = supervisorOffenders[i];
+        Serial.println("Offender " + String(opBudgets[o.op].name) + " " + String(o.ms) +
+                       "ms at " + String(o.atSec) + "s");
+    }
+}
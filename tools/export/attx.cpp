@@ -0,0 +1,341 @@
+// Host side of the compact attendance export (attendance_format.h).
+//
+// Build (from the repository root):
+//   g++ -std=gnu++17 -O2 -I . tools/export/attx.cpp -o attx
+//
+// Usage:
+//   attx decode attendance.bin                 CSV on stdout, same lines as /attendance.csv
+//   attx verify attendance.bin attendance.csv  checks every block and compares with the log
+//   attx encode attendance.csv attendance.bin  reference encoder, same output as the device
+//   attx bench [attendance.csv | --synthetic N]
+//                                              size and encode/decode speed vs JSON
+//
+// Exit status: 0 ok, 1 corrupt export or mismatch, 2 usage or I/O error.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "attendance_format.h"
+
+namespace {
+
+struct Decoded {
+    std::vector<ExportRecord> records;
+    uint32_t exported = 0;
+    uint32_t skipped = 0;
+    uint32_t blocks = 0;
+};
+
+bool readFile(const char* path, std::string& out) {
+    FILE* f = fopen(path, "rb");
+    if (f == nullptr) {
+        fprintf(stderr, "attx: cannot open %s\n", path);
+        return false;
+    }
+    char buffer[65536];
+    size_t n;
+    while ((n = fread(buffer, 1, sizeof(buffer), f)) > 0) {
+        out.append(buffer, n);
+    }
+    fclose(f);
+    return true;
+}
+
+// Parses the log the way the device does; unreadable lines are counted
+std::vector<ExportRecord> parseCsv(const std::string& csv, uint32_t& skipped) {
+    std::vector<ExportRecord> records;
+    skipped = 0;
+    size_t pos = 0;
+    while (pos < csv.size()) {
+        size_t eol = csv.find('\n', pos);
+        if (eol == std::string::npos) {
+            // Cut off mid-write, the device skips it too
+            skipped++;
+            break;
+        }
+        std::string line = csv.substr(pos, eol - pos);
+        pos = eol + 1;
+
+        ExportRecord record;
+        if (line.size() < 32 && exportParseLine(line.c_str(), record)) {
+            records.push_back(record);
+        } else {
+            skipped++;
+        }
+    }
+    return records;
+}
+
+std::string encode(const std::vector<ExportRecord>& records, uint32_t skipped) {
+    std::string out;
+    uint8_t block[EXPORT_BLOCK_MAX];
+    out.append((const char*)block, exportWriteHeader(block));
+    for (size_t i = 0; i < records.size(); i += EXPORT_BLOCK_RECORDS) {
+        uint16_t count = std::min<size_t>(EXPORT_BLOCK_RECORDS, records.size() - i);
+        out.append((const char*)block, exportEncodeBlock(block, &records[i], count));
+    }
+    out.append((const char*)block, exportEncodeEnd(block, records.size(), skipped));
+    return out;
+}
+
+bool decode(const std::string& data, Decoded& result, bool report) {
+    const uint8_t* p = (const uint8_t*)data.data();
+    size_t left = data.size();
+    if (left < EXPORT_HEADER_LEN || !exportCheckHeader(p)) {
+        if (report) {
+            fprintf(stderr, "attx: not an attendance export (version %d)\n", EXPORT_VERSION);
+        }
+        return false;
+    }
+    p += EXPORT_HEADER_LEN;
+    left -= EXPORT_HEADER_LEN;
+
+    ExportRecord records[EXPORT_BLOCK_RECORDS];
+    for (;;) {
+        uint16_t count;
+        size_t used;
+        ExportStatus status = exportDecodeBlock(p, left, records, count, used, result.exported, result.skipped);
+        if (status == EXPORT_OK) {
+            result.records.insert(result.records.end(), records, records + count);
+            result.blocks++;
+            p += used;
+            left -= used;
+            continue;
+        }
+        if (status == EXPORT_END) {
+            if (left != used && report) {
+                fprintf(stderr, "attx: %zu bytes after the end block\n", left - used);
+            }
+            if (result.exported != result.records.size()) {
+                if (report) {
+                    fprintf(stderr, "attx: end block says %u records, decoded %zu\n", result.exported,
+                            result.records.size());
+                }
+                return false;
+            }
+            return left == used;
+        }
+        if (report) {
+            static const char* reasons[] = {"", "", "truncated (no end block)", "checksum mismatch", "malformed"};
+            fprintf(stderr, "attx: block %u at offset %zu: %s\n", result.blocks, data.size() - left,
+                    reasons[status]);
+        }
+        return false;
+    }
+}
+
+std::string toJson(const std::vector<ExportRecord>& records) {
+    std::string out = "[";
+    char item[64];
+    for (size_t i = 0; i < records.size(); i++) {
+        int n = snprintf(item, sizeof(item), "%s{\"time\":%u,\"id\":%u,\"confidence\":%u}", i ? "," : "",
+                         records[i].time, records[i].id, records[i].confidence);
+        out.append(item, n);
+    }
+    out += "]";
+    return out;
+}
+
+// Just enough JSON to read back what toJson() writes
+std::vector<ExportRecord> fromJson(const std::string& json) {
+    std::vector<ExportRecord> records;
+    const char* p = json.c_str();
+    while ((p = strstr(p, "{\"time\":")) != nullptr) {
+        ExportRecord r;
+        char* end;
+        r.time = strtoul(p + 8, &end, 10);
+        r.id = strtoul(strstr(end, "\"id\":") + 5, &end, 10);
+        r.confidence = strtoul(strstr(end, "\"confidence\":") + 13, &end, 10);
+        records.push_back(r);
+        p = end;
+    }
+    return records;
+}
+
+// Two scans a day (in and out) for every employee
+std::vector<ExportRecord> synthetic(size_t n) {
+    std::vector<ExportRecord> records;
+    uint32_t seed = 12345;
+    auto next = [&seed]() { return seed = seed * 1103515245 + 12345, (seed >> 16) & 0x7FFF; };
+    uint32_t day = 1767225600;  // 2026-01-01 00:00 UTC
+    const uint16_t employees = 150;
+
+    while (records.size() < n) {
+        for (int shift = 0; shift < 2 && records.size() < n; shift++) {
+            uint32_t t = day + (shift ? 17 * 3600 : 7 * 3600 + 1800);
+            for (uint16_t e = 0; e < employees && records.size() < n; e++) {
+                t += next() % 20;
+                records.push_back({t, (uint16_t)(1 + next() % employees), (uint16_t)(60 + next() % 200)});
+            }
+        }
+        day += 86400;
+    }
+    return records;
+}
+
+std::string toCsv(const std::vector<ExportRecord>& records) {
+    std::string out;
+    char line[32];
+    for (const ExportRecord& r : records) {
+        out.append(line, snprintf(line, sizeof(line), "%u,%u,%u\n", r.time, r.id, r.confidence));
+    }
+    return out;
+}
+
+bool writeFile(const char* path, const std::string& data) {
+    FILE* f = fopen(path, "wb");
+    if (f == nullptr || fwrite(data.data(), 1, data.size(), f) != data.size()) {
+        fprintf(stderr, "attx: cannot write %s\n", path);
+        if (f != nullptr) {
+            fclose(f);
+        }
+        return false;
+    }
+    return fclose(f) == 0;
+}
+
+template <class F> double timeMs(F fn, int rounds) {
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < rounds; i++) {
+        fn();
+    }
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() / rounds;
+}
+
+int cmdDecode(const char* path) {
+    std::string data;
+    if (!readFile(path, data)) {
+        return 2;
+    }
+    Decoded result;
+    bool ok = decode(data, result, true);
+    fputs(toCsv(result.records).c_str(), stdout);
+    fprintf(stderr, "attx: %zu records in %u blocks, %u log lines skipped on the device\n",
+            result.records.size(), result.blocks, result.skipped);
+    return ok ? 0 : 1;
+}
+
+int cmdVerify(const char* binPath, const char* csvPath) {
+    std::string data, csv;
+    if (!readFile(binPath, data) || !readFile(csvPath, csv)) {
+        return 2;
+    }
+    Decoded result;
+    if (!decode(data, result, true)) {
+        return 1;
+    }
+    uint32_t skipped;
+    std::vector<ExportRecord> expected = parseCsv(csv, skipped);
+
+    // The log may have grown since the export was taken
+    if (result.records.size() > expected.size()) {
+        fprintf(stderr, "attx: export has %zu records, log only %zu\n", result.records.size(), expected.size());
+        return 1;
+    }
+    for (size_t i = 0; i < result.records.size(); i++) {
+        const ExportRecord& a = result.records[i];
+        const ExportRecord& b = expected[i];
+        if (a.time != b.time || a.id != b.id || a.confidence != b.confidence) {
+            fprintf(stderr, "attx: record %zu differs: %u,%u,%u vs %u,%u,%u in the log\n", i, a.time, a.id,
+                    a.confidence, b.time, b.id, b.confidence);
+            return 1;
+        }
+    }
+    printf("OK: %zu records in %u blocks match %s", result.records.size(), result.blocks, csvPath);
+    if (expected.size() > result.records.size()) {
+        printf(" (%zu newer lines not in the export)", expected.size() - result.records.size());
+    }
+    printf("\n");
+    return 0;
+}
+
+int cmdEncode(const char* csvPath, const char* binPath) {
+    std::string csv;
+    if (!readFile(csvPath, csv)) {
+        return 2;
+    }
+    uint32_t skipped;
+    std::vector<ExportRecord> records = parseCsv(csv, skipped);
+    return writeFile(binPath, encode(records, skipped)) ? 0 : 2;
+}
+
+int cmdBench(const std::vector<ExportRecord>& records) {
+    if (records.empty()) {
+        fprintf(stderr, "attx: nothing to benchmark\n");
+        return 2;
+    }
+    int rounds = std::max<int>(1, 2000000 / records.size());
+    std::string csv = toCsv(records);
+    std::string json = toJson(records);
+    std::string compact = encode(records, 0);
+
+    Decoded check;
+    if (!decode(compact, check, true) || check.records.size() != records.size() || fromJson(json).size() != records.size()) {
+        fprintf(stderr, "attx: round trip failed\n");
+        return 1;
+    }
+
+    double jsonEncode = timeMs([&] { toJson(records); }, rounds);
+    double jsonDecode = timeMs([&] { fromJson(json); }, rounds);
+    double compactEncode = timeMs([&] { encode(records, 0); }, rounds);
+    double compactDecode = timeMs([&] { Decoded d; decode(compact, d, false); }, rounds);
+
+    printf("%zu records\n", records.size());
+    printf("%-8s %10s %8s %14s %14s\n", "format", "bytes", "B/rec", "encode rec/s", "decode rec/s");
+    auto row = [&](const char* name, size_t bytes, double enc, double dec) {
+        printf("%-8s %10zu %8.2f", name, bytes, (double)bytes / records.size());
+        if (enc > 0) {
+            printf(" %14.0f %14.0f", records.size() / enc * 1000, records.size() / dec * 1000);
+        }
+        printf("\n");
+    };
+    row("csv", csv.size(), 0, 0);
+    row("json", json.size(), jsonEncode, jsonDecode);
+    row("compact", compact.size(), compactEncode, compactDecode);
+    printf("compact is %.1f%% of JSON, %.1f%% of CSV\n", 100.0 * compact.size() / json.size(),
+           100.0 * compact.size() / csv.size());
+    return 0;
+}
+
+void usage() {
+    fprintf(stderr,
+            "usage: attx decode FILE.bin\n"
+            "       attx verify FILE.bin attendance.csv\n"
+            "       attx encode attendance.csv FILE.bin\n"
+            "       attx bench [attendance.csv | --synthetic N]\n");
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    std::string cmd = argc > 1 ? argv[1] : "";
+    if (cmd == "decode" && argc == 3) {
+        return cmdDecode(argv[2]);
+    }
+    if (cmd == "verify" && argc == 4) {
+        return cmdVerify(argv[2], argv[3]);
+    }
+    if (cmd == "encode" && argc == 4) {
+        return cmdEncode(argv[2], argv[3]);
+    }
+    if (cmd == "bench" && argc == 4 && std::string(argv[2]) == "--synthetic") {
+        return cmdBench(synthetic(strtoul(argv[3], nullptr, 10)));
+    }
+    if (cmd == "bench" && argc <= 3) {
+        if (argc == 2) {
+            return cmdBench(synthetic(10000));
+        }
+        std::string csv;
+        if (!readFile(argv[2], csv)) {
+            return 2;
+        }
+        uint32_t skipped;
+        return cmdBench(parseCsv(csv, skipped));
+    }
+    usage();
+    return 2;
+}
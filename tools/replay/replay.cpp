@@ -0,0 +1,565 @@
+// Offline replay of a device input trace (see trace.h).
+//
+// Builds the unmodified sketch for the host against the stand-ins in shim/
+// and feeds it what the device saw: sensor replies, button edges, RTC time,
+// WiFi events and console input, on a simulated clock. Everything runs on
+// one thread; the scan tasks are stepped from the main loop every
+// SCAN_POLL_MS and the supervisor task is not started.
+//
+// Build (from the repository root):
+//   g++ -std=gnu++17 -O1 -I tools/replay/shim -I . tools/replay/replay.cpp -o replay
+//
+// Usage:
+//   replay [--list] [--boot N] [--fs DIR] [--max-ms MS] [--quiet] trace.old trace.bin
+//
+// Files are concatenated in the order given, so pass /trace.old before
+// /trace.bin. --fs points at a copy of the device's LittleFS (ssid.txt,
+// attendance.csv, ...); whatever the firmware writes during the replay ends
+// up there too. Exit status: 0 replayed, 1 the firmware diverged from the
+// trace, 2 unreadable trace.
+
+#include "Arduino.h"
+#include <algorithm>
+#include <chrono>
+#include <map>
+#include <vector>
+
+#include "../../iot-st.ino"
+
+// Shim globals
+HardwareSerial Serial(0);
+EspClass ESP;
+TwoWire Wire;
+WiFiClass WiFi;
+fs::LittleFSFS LittleFS;
+
+namespace {
+
+struct ReplayEnd {
+    std::string why;
+};
+
+struct ReplayDivergence {
+    std::string what;
+};
+
+struct DataPacket {
+    uint8_t pid;
+    uint16_t len;
+};
+
+struct Reply {
+    uint32_t ms;
+    uint8_t command;
+    uint16_t latencyMs;
+    uint32_t repeats;       // further identical replies folded into this one
+    uint32_t windowEndMs;   // folded replies happened before this time
+    uint32_t used = 0;
+    uint16_t length;
+    std::vector<uint8_t> payload;
+    std::vector<DataPacket> data;
+};
+
+struct AsyncEvent {
+    uint32_t ms;
+    uint8_t type;
+    uint8_t source;
+    uint8_t op;
+};
+
+struct Segment {
+    size_t begin, end;      // record range, TRACE_BOOT first
+};
+
+struct CommandStats {
+    uint32_t count = 0;
+    uint64_t recordedMs = 0;
+};
+
+// Simulated clock and inputs
+uint64_t fakeMs = 0;
+std::vector<Reply> replies[SENSOR_COUNT];
+size_t replyNext[SENSOR_COUNT];
+std::vector<std::pair<uint32_t, uint32_t>> rtcReadings;   // ms, unixtime
+std::vector<AsyncEvent> events;
+size_t eventNext = 0;
+std::map<int, void (*)()> interrupts;
+R30xParser commandParsers[SENSOR_COUNT];
+unsigned long scanDue[SENSOR_COUNT];
+
+// Options
+bool quiet = false;
+uint64_t maxMs = 0;
+
+// Statistics
+uint32_t repliesServed = 0;
+uint32_t repliesSkipped = 0;
+uint32_t eventsDelivered = 0;
+uint32_t buttonMismatches = 0;
+uint32_t droppedRecords = 0;
+std::map<uint8_t, CommandStats> commandStats;
+
+const char* reasonName(uint8_t reason) {
+    static const char* names[] = {"unknown", "power-on", "ext", "software", "panic", "int-wdt",
+                                  "task-wdt", "wdt", "deep-sleep", "brownout", "sdio"};
+    return reason < sizeof(names) / sizeof(names[0]) ? names[reason] : "?";
+}
+
+bool loadTrace(const char* path, std::vector<TraceRecord>& records) {
+    FILE* f = fopen(path, "rb");
+    if (f == nullptr) {
+        fprintf(stderr, "replay: cannot open %s\n", path);
+        return false;
+    }
+    TraceHeader header;
+    if (fread(&header, sizeof(header), 1, f) != 1 || header.magic != TRACE_MAGIC) {
+        fprintf(stderr, "replay: %s is not a trace file\n", path);
+        fclose(f);
+        return false;
+    }
+    // Version 1 only lacks TRACE_SENSOR_REPEAT, same records otherwise
+    if (header.version < 1 || header.version > TRACE_VERSION || header.recordSize != sizeof(TraceRecord)) {
+        fprintf(stderr, "replay: %s has version %u, record size %u (expected up to %u, %u)\n", path,
+                header.version, header.recordSize, TRACE_VERSION, (unsigned)sizeof(TraceRecord));
+        fclose(f);
+        return false;
+    }
+    TraceRecord r;
+    while (fread(&r, sizeof(r), 1, f) == 1) {
+        records.push_back(r);
+    }
+    fclose(f);
+    return true;
+}
+
+std::vector<Segment> splitBoots(const std::vector<TraceRecord>& records) {
+    std::vector<Segment> segments;
+    for (size_t i = 0; i < records.size(); i++) {
+        if (records[i].type == TRACE_BOOT) {
+            if (!segments.empty()) {
+                segments.back().end = i;
+            }
+            segments.push_back({i, records.size()});
+        }
+    }
+    return segments;
+}
+
+void prepare(const std::vector<TraceRecord>& records, const Segment& seg) {
+    for (size_t i = seg.begin; i < seg.end; i++) {
+        const TraceRecord& r = records[i];
+        if ((r.type == TRACE_SENSOR || r.type == TRACE_SENSOR_MORE || r.type == TRACE_SENSOR_DATA ||
+             r.type == TRACE_SENSOR_REPEAT) &&
+            r.source >= SENSOR_COUNT) {
+            continue;
+        }
+
+        switch (r.type) {
+        case TRACE_SENSOR: {
+            Reply reply;
+            reply.ms = r.ms;
+            reply.command = r.op;
+            reply.latencyMs = r.latencyMs;
+            reply.repeats = r.repeat;
+            reply.windowEndMs = r.ms;
+            reply.length = r.len;
+            reply.payload.assign(r.data, r.data + std::min<int>(r.len, TRACE_DATA_LEN));
+            replies[r.source].push_back(reply);
+            break;
+        }
+        case TRACE_SENSOR_MORE:
+            if (!replies[r.source].empty()) {
+                std::vector<uint8_t>& payload = replies[r.source].back().payload;
+                payload.insert(payload.end(), r.data, r.data + std::min<int>(r.len, TRACE_DATA_LEN));
+            }
+            break;
+        case TRACE_SENSOR_REPEAT:
+            // Repeats of a fold that stayed open across a flush on the device
+            if (!replies[r.source].empty()) {
+                replies[r.source].back().repeats += r.repeat;
+            }
+            break;
+        case TRACE_SENSOR_DATA:
+            if (!replies[r.source].empty()) {
+                uint16_t len;
+                memcpy(&len, r.data, sizeof(len));
+                replies[r.source].back().data.push_back({r.op, len});
+            }
+            break;
+        case TRACE_RTC: {
+            uint32_t unixtime;
+            memcpy(&unixtime, r.data, sizeof(unixtime));
+            rtcReadings.push_back({r.ms, unixtime});
+            break;
+        }
+        case TRACE_BUTTON:
+        case TRACE_WIFI:
+        case TRACE_CONSOLE:
+            events.push_back({r.ms, r.type, r.source, r.op});
+            break;
+        case TRACE_DROPPED:
+            droppedRecords += r.repeat;
+            fprintf(stderr, "replay: warning: %u records were dropped on the device at %u ms\n",
+                    r.repeat, r.ms);
+            break;
+        }
+    }
+
+    // Folded replies were spread over the time until the sensor's next reply
+    for (int s = 0; s < SENSOR_COUNT; s++) {
+        for (size_t i = 0; i < replies[s].size(); i++) {
+            Reply& reply = replies[s][i];
+            // Zero-filled where the device lost MORE records
+            reply.payload.resize(reply.length);
+            if (reply.repeats > 0) {
+                reply.windowEndMs = i + 1 < replies[s].size() ? replies[s][i + 1].ms : reply.ms +
+                                    (reply.repeats + 1) * (reply.latencyMs + SCAN_POLL_MS);
+            }
+        }
+    }
+    std::stable_sort(events.begin(), events.end(),
+                     [](const AsyncEvent& a, const AsyncEvent& b) { return a.ms < b.ms; });
+}
+
+void showLcd() {
+    if (!lcd.dirty) {
+        return;
+    }
+    lcd.dirty = false;
+    if (!quiet) {
+        printf("[%8.3f] LCD |%s|%s|\n", fakeMs / 1000.0, lcd.lines[0], lcd.lines[1]);
+    }
+}
+
+void deliver(const AsyncEvent& ev) {
+    eventsDelivered++;
+    switch (ev.type) {
+    case TRACE_BUTTON: {
+        static const std::map<uint8_t, std::pair<int, volatile unsigned long*>> keys = {
+            {MENU_KEY_LEFT, {BTN_LEFT, &lastLeftInterrupt}},
+            {MENU_KEY_SELECT, {BTN_SELECT, &lastSelectInterrupt}},
+            {MENU_KEY_RIGHT, {BTN_RIGHT, &lastRightInterrupt}},
+        };
+        auto key = keys.find(ev.source);
+        if (key == keys.end() || interrupts.count(key->second.first) == 0) {
+            break;
+        }
+        unsigned long before = *key->second.second;
+        interrupts[key->second.first]();
+        bool accepted = *key->second.second != before;
+        if (accepted != (ev.op != 0)) {
+            buttonMismatches++;
+            fprintf(stderr, "replay: button %u at %u ms was %s on the device but %s here\n", ev.source,
+                    ev.ms, ev.op ? "accepted" : "debounced", accepted ? "accepted" : "debounced");
+        }
+        break;
+    }
+    case TRACE_WIFI:
+        WiFi.deliver(ev.op);
+        break;
+    case TRACE_CONSOLE:
+        Serial.rx.push_back(ev.op);
+        break;
+    }
+}
+
+// Moves the clock to ms, delivering every event that falls on the way
+void advanceTo(uint64_t ms) {
+    while (eventNext < events.size() && events[eventNext].ms <= ms) {
+        const AsyncEvent& ev = events[eventNext++];
+        fakeMs = std::max<uint64_t>(fakeMs, ev.ms);
+        deliver(ev);
+    }
+    fakeMs = std::max(fakeMs, ms);
+    showLcd();
+    if (maxMs != 0 && fakeMs >= maxMs) {
+        throw ReplayEnd{"--max-ms reached"};
+    }
+}
+
+void queuePacket(std::deque<uint8_t>& rx, uint8_t pid, const uint8_t* payload, uint16_t len) {
+    uint16_t wireLen = len + 2;
+    const uint8_t header[9] = {0xEF, 0x01, 0xFF, 0xFF, 0xFF, 0xFF, pid, (uint8_t)(wireLen >> 8), (uint8_t)wireLen};
+    uint16_t sum = pid + (wireLen >> 8) + (wireLen & 0xFF);
+    rx.insert(rx.end(), header, header + sizeof(header));
+    for (uint16_t i = 0; i < len; i++) {
+        uint8_t b = payload != nullptr ? payload[i] : 0;
+        rx.push_back(b);
+        sum += b;
+    }
+    rx.push_back(sum >> 8);
+    rx.push_back(sum & 0xFF);
+}
+
+// The next recorded reply for a command, catching up on folded replies that
+// fell into time the replay spent elsewhere
+Reply* nextReply(int s, uint8_t command) {
+    while (replyNext[s] < replies[s].size()) {
+        Reply& reply = replies[s][replyNext[s]];
+        if (reply.repeats > 0 && fakeMs > reply.ms) {
+            uint64_t span = std::max<uint32_t>(reply.windowEndMs - reply.ms, 1);
+            uint32_t due = std::min<uint64_t>((fakeMs - reply.ms) * (reply.repeats + 1) / span, reply.repeats);
+            if (due > reply.used) {
+                repliesSkipped += due - reply.used;
+                reply.used = due;
+            }
+        }
+        if (reply.command == command) {
+            return &reply;
+        }
+        if (reply.repeats > 0 && reply.used > 0) {
+            // The device polled a few more times than we did
+            repliesSkipped += reply.repeats + 1 - reply.used;
+            replyNext[s]++;
+            continue;
+        }
+        char what[96];
+        snprintf(what, sizeof(what), "sensor %d sent command 0x%02X, trace has 0x%02X at %u ms",
+                 s, command, reply.command, reply.ms);
+        throw ReplayDivergence{what};
+    }
+    throw ReplayEnd{"sensor " + std::to_string(s) + " replies exhausted"};
+}
+
+void onCommand(int s, const R30xParser& packet) {
+    uint8_t command = packet.payload[0];
+    Reply& reply = *nextReply(s, command);
+
+    if (reply.used == 0) {
+        advanceTo(reply.ms);
+    } else {
+        advanceTo(fakeMs + reply.latencyMs);
+    }
+    if (++reply.used > reply.repeats) {
+        replyNext[s]++;
+    }
+
+    repliesServed++;
+    CommandStats& stats = commandStats[command];
+    stats.count++;
+    stats.recordedMs += reply.latencyMs;
+
+    HardwareSerial& serial = sensors[s].serial;
+    queuePacket(serial.rx, FINGERPRINT_ACKPACKET, reply.payload.data(), reply.payload.size());
+    for (const DataPacket& data : reply.data) {
+        queuePacket(serial.rx, data.pid, nullptr, data.len);
+    }
+}
+
+bool inputsLeft() {
+    if (eventNext < events.size()) {
+        return true;
+    }
+    // The tail of a folded reply is optional, the device may have been idle
+    for (int s = 0; s < SENSOR_COUNT; s++) {
+        size_t left = replies[s].size() - replyNext[s];
+        if (left > 1 || (left == 1 && replies[s].back().used == 0)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void printSummary(double wallSeconds) {
+    printf("\n=== Replay summary ===\n");
+    printf("Simulated %.3f s in %.3f s wall\n", fakeMs / 1000.0, wallSeconds);
+    printf("Sensor replies served: %u, folded replies skipped: %u\n", repliesServed, repliesSkipped);
+    printf("Events delivered: %u of %zu, button mismatches: %u\n", eventsDelivered, events.size(), buttonMismatches);
+    if (droppedRecords > 0) {
+        printf("Records dropped on the device: %u\n", droppedRecords);
+    }
+    for (const auto& entry : commandStats) {
+        printf("  cmd 0x%02X: %u replies, recorded avg %.1f ms\n", entry.first, entry.second.count,
+               (double)entry.second.recordedMs / entry.second.count);
+    }
+    quiet = false;
+    printScanStats();
+    printMatchLatencyStats();
+    printStatusStats();
+}
+
+void usage() {
+    fprintf(stderr, "usage: replay [--list] [--boot N] [--fs DIR] [--max-ms MS] [--quiet] trace...\n");
+}
+
+}  // namespace
+
+// Arduino and FreeRTOS on the simulated clock
+unsigned long millis() { return fakeMs; }
+unsigned long micros() { return fakeMs * 1000; }
+void delay(unsigned long ms) { advanceTo(fakeMs + ms); }
+void delayMicroseconds(unsigned) {}
+void yield() {}
+void vTaskDelay(TickType_t ticks) { advanceTo(fakeMs + ticks); }
+TickType_t xTaskGetTickCount() { return fakeMs; }
+
+void pinMode(int, int) {}
+int digitalRead(int) { return HIGH; }
+void attachInterrupt(int pin, void (*isr)(), int) { interrupts[pin] = isr; }
+void detachInterrupt(int pin) { interrupts.erase(pin); }
+
+void EspClass::restart() { throw ReplayEnd{"ESP.restart()"}; }
+
+BaseType_t xTaskCreatePinnedToCore(void (*)(void*), const char*, uint32_t, void*, UBaseType_t, TaskHandle_t* handle,
+                                   BaseType_t) {
+    if (handle != nullptr) {
+        *handle = nullptr;
+    }
+    return pdPASS;
+}
+
+BaseType_t xTaskCreate(void (*fn)(void*), const char* name, uint32_t stack, void* arg, UBaseType_t priority,
+                       TaskHandle_t* handle) {
+    return xTaskCreatePinnedToCore(fn, name, stack, arg, priority, handle, 0);
+}
+
+struct ShimQueue {
+    size_t itemSize, length;
+    std::deque<std::vector<uint8_t>> items;
+};
+
+QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t itemSize) { return new ShimQueue{itemSize, length, {}}; }
+
+BaseType_t xQueueSend(QueueHandle_t queue, const void* item, TickType_t) {
+    ShimQueue* q = (ShimQueue*)queue;
+    if (q->items.size() >= q->length) {
+        return pdFALSE;
+    }
+    q->items.emplace_back((const uint8_t*)item, (const uint8_t*)item + q->itemSize);
+    return pdTRUE;
+}
+
+BaseType_t xQueueReceive(QueueHandle_t queue, void* item, TickType_t) {
+    ShimQueue* q = (ShimQueue*)queue;
+    if (q->items.empty()) {
+        return pdFALSE;
+    }
+    memcpy(item, q->items.front().data(), q->itemSize);
+    q->items.pop_front();
+    return pdTRUE;
+}
+
+BaseType_t xQueueReset(QueueHandle_t queue) {
+    ((ShimQueue*)queue)->items.clear();
+    return pdPASS;
+}
+
+void vQueueDelete(QueueHandle_t queue) { delete (ShimQueue*)queue; }
+
+// UART 0 is the console; the other ports are sensors answered from the trace
+size_t HardwareSerial::write(uint8_t c) {
+    if (this == &Serial) {
+        if (!quiet) {
+            putchar(c);
+        }
+        return 1;
+    }
+    for (int s = 0; s < SENSOR_COUNT; s++) {
+        if (this == &sensors[s].serial && commandParsers[s].feed(c) &&
+            commandParsers[s].pid == FINGERPRINT_COMMANDPACKET) {
+            onCommand(s, commandParsers[s]);
+        }
+    }
+    return 1;
+}
+
+// The clock as the device last read it, running on from there
+uint32_t replayRtcRead() {
+    auto after = std::upper_bound(rtcReadings.begin(), rtcReadings.end(), std::make_pair((uint32_t)fakeMs, UINT32_MAX));
+    if (after == rtcReadings.begin()) {
+        return rtcReadings.empty() ? 0 : rtcReadings.front().second;
+    }
+    const auto& reading = *(after - 1);
+    return reading.second + (fakeMs - reading.first) / 1000;
+}
+
+int main(int argc, char** argv) {
+    std::vector<const char*> paths;
+    bool list = false;
+    int boot = -1;
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--list") {
+            list = true;
+        } else if (arg == "--quiet") {
+            quiet = true;
+        } else if (arg == "--boot" && i + 1 < argc) {
+            boot = atoi(argv[++i]);
+        } else if (arg == "--fs" && i + 1 < argc) {
+            LittleFS.root = argv[++i];
+        } else if (arg == "--max-ms" && i + 1 < argc) {
+            maxMs = strtoull(argv[++i], nullptr, 10);
+        } else if (arg[0] == '-') {
+            usage();
+            return 2;
+        } else {
+            paths.push_back(argv[i]);
+        }
+    }
+    if (paths.empty()) {
+        usage();
+        return 2;
+    }
+
+    std::vector<TraceRecord> records;
+    for (const char* path : paths) {
+        if (!loadTrace(path, records)) {
+            return 2;
+        }
+    }
+    std::vector<Segment> segments = splitBoots(records);
+    if (segments.empty()) {
+        fprintf(stderr, "replay: no boot found in the trace\n");
+        return 2;
+    }
+
+    if (list) {
+        for (size_t i = 0; i < segments.size(); i++) {
+            const Segment& seg = segments[i];
+            printf("boot %zu: %zu records, %.1f s, reset reason %s\n", i, seg.end - seg.begin,
+                   records[seg.end - 1].ms / 1000.0, reasonName(records[seg.begin].op));
+        }
+        return 0;
+    }
+    if (boot < 0) {
+        boot = segments.size() - 1;
+    }
+    if (boot >= (int)segments.size()) {
+        fprintf(stderr, "replay: trace has %zu boots\n", segments.size());
+        return 2;
+    }
+    prepare(records, segments[boot]);
+
+    // The replay must not record itself
+    traceEnabled = false;
+
+    int status = 0;
+    auto wallStart = std::chrono::steady_clock::now();
+    try {
+        setup();
+        while (inputsLeft()) {
+            loop();
+            for (int s = 0; s < SENSOR_COUNT; s++) {
+                if (fakeMs >= scanDue[s]) {
+                    scanTaskStep(sensors[s]);
+                    scanDue[s] = fakeMs + SCAN_POLL_MS;
+                }
+            }
+            showLcd();
+        }
+        printf("\nreplay: all inputs consumed\n");
+    } catch (const ReplayEnd& end) {
+        printf("\nreplay: stopped, %s\n", end.why.c_str());
+    } catch (const ReplayDivergence& divergence) {
+        printf("\nreplay: DIVERGED, %s\n", divergence.what.c_str());
+        status = 1;
+    }
+    double wall = std::chrono::duration<double>(std::chrono::steady_clock::now() - wallStart).count();
+
+    printSummary(wall);
+    if (buttonMismatches > 0) {
+        status = 1;
+    }
+    return status;
+}
@@ -0,0 +1,186 @@
+#pragma once
+// Protocol-level stand-in for the Adafruit library: the calls the firmware
+// makes are sent as real R30x packets over the stream, so the replay engine
+// sees (and answers) exactly the traffic the device produced.
+
+#include "Arduino.h"
+
+#define FINGERPRINT_OK 0x00
+#define FINGERPRINT_PACKETRECIEVEERR 0x01
+#define FINGERPRINT_NOFINGER 0x02
+#define FINGERPRINT_IMAGEFAIL 0x03
+#define FINGERPRINT_IMAGEMESS 0x06
+#define FINGERPRINT_FEATUREFAIL 0x07
+#define FINGERPRINT_NOMATCH 0x08
+#define FINGERPRINT_NOTFOUND 0x09
+#define FINGERPRINT_ENROLLMISMATCH 0x0A
+#define FINGERPRINT_BADLOCATION 0x0B
+#define FINGERPRINT_DBREADFAIL 0x0C
+#define FINGERPRINT_UPLOADFEATUREFAIL 0x0D
+#define FINGERPRINT_PACKETRESPONSEFAIL 0x0E
+#define FINGERPRINT_UPLOADFAIL 0x0F
+#define FINGERPRINT_DELETEFAIL 0x10
+#define FINGERPRINT_DBCLEARFAIL 0x11
+#define FINGERPRINT_PASSFAIL 0x13
+#define FINGERPRINT_INVALIDIMAGE 0x15
+#define FINGERPRINT_FLASHERR 0x18
+#define FINGERPRINT_INVALIDREG 0x1A
+#define FINGERPRINT_ADDRCODE 0x20
+#define FINGERPRINT_PASSVERIFY 0x21
+
+#define FINGERPRINT_STARTCODE 0xEF01
+#define FINGERPRINT_COMMANDPACKET 0x1
+#define FINGERPRINT_DATAPACKET 0x2
+#define FINGERPRINT_ACKPACKET 0x7
+#define FINGERPRINT_ENDDATAPACKET 0x8
+
+#define FINGERPRINT_TIMEOUT 0xFF
+#define FINGERPRINT_BADPACKET 0xFE
+
+#define FINGERPRINT_GETIMAGE 0x01
+#define FINGERPRINT_IMAGE2TZ 0x02
+#define FINGERPRINT_SEARCH 0x04
+#define FINGERPRINT_REGMODEL 0x05
+#define FINGERPRINT_STORE 0x06
+#define FINGERPRINT_LOAD 0x07
+#define FINGERPRINT_UPLOAD 0x08
+#define FINGERPRINT_DELETE 0x0C
+#define FINGERPRINT_EMPTY 0x0D
+#define FINGERPRINT_READSYSPARAM 0x0F
+#define FINGERPRINT_VERIFYPASSWORD 0x13
+#define FINGERPRINT_HISPEEDSEARCH 0x1B
+#define FINGERPRINT_TEMPLATECOUNT 0x1D
+
+#define DEFAULTTIMEOUT 1000
+
+class Adafruit_Fingerprint {
+public:
+    explicit Adafruit_Fingerprint(Stream* port, uint32_t password = 0) : port(port), password(password) {}
+
+    void begin(uint32_t) {}
+
+    bool verifyPassword() {
+        uint8_t cmd[] = {FINGERPRINT_VERIFYPASSWORD, (uint8_t)(password >> 24), (uint8_t)(password >> 16),
+                         (uint8_t)(password >> 8), (uint8_t)password};
+        return command(cmd, sizeof(cmd)) == FINGERPRINT_OK;
+    }
+
+    uint8_t getParameters() {
+        uint8_t cmd[] = {FINGERPRINT_READSYSPARAM};
+        uint8_t p = command(cmd, sizeof(cmd));
+        if (p == FINGERPRINT_OK && replyLen >= 17) {
+            status_reg = be16(1);
+            system_id = be16(3);
+            capacity = be16(5);
+            security_level = be16(7);
+            device_addr = ((uint32_t)be16(9) << 16) | be16(11);
+            packet_len = 32 << be16(13);
+            baud_rate = be16(15) * 9600;
+        }
+        return p;
+    }
+
+    uint8_t getImage() { uint8_t cmd[] = {FINGERPRINT_GETIMAGE}; return command(cmd, sizeof(cmd)); }
+    uint8_t image2Tz(uint8_t slot = 1) { uint8_t cmd[] = {FINGERPRINT_IMAGE2TZ, slot}; return command(cmd, sizeof(cmd)); }
+    uint8_t createModel() { uint8_t cmd[] = {FINGERPRINT_REGMODEL}; return command(cmd, sizeof(cmd)); }
+    uint8_t emptyDatabase() { uint8_t cmd[] = {FINGERPRINT_EMPTY}; return command(cmd, sizeof(cmd)); }
+
+    uint8_t storeModel(uint16_t id) {
+        uint8_t cmd[] = {FINGERPRINT_STORE, 0x01, (uint8_t)(id >> 8), (uint8_t)id};
+        return command(cmd, sizeof(cmd));
+    }
+    uint8_t loadModel(uint16_t id) {
+        uint8_t cmd[] = {FINGERPRINT_LOAD, 0x01, (uint8_t)(id >> 8), (uint8_t)id};
+        return command(cmd, sizeof(cmd));
+    }
+    uint8_t deleteModel(uint16_t id) {
+        uint8_t cmd[] = {FINGERPRINT_DELETE, (uint8_t)(id >> 8), (uint8_t)id, 0x00, 0x01};
+        return command(cmd, sizeof(cmd));
+    }
+
+    uint8_t fingerFastSearch() {
+        uint8_t cmd[] = {FINGERPRINT_HISPEEDSEARCH, 0x01, 0x00, 0x00, 0x00, 0xA3};
+        return searchReply(command(cmd, sizeof(cmd)));
+    }
+    uint8_t fingerSearch(uint8_t slot = 1) {
+        uint8_t cmd[] = {FINGERPRINT_SEARCH, slot, 0x00, 0x00, (uint8_t)(capacity >> 8), (uint8_t)capacity};
+        return searchReply(command(cmd, sizeof(cmd)));
+    }
+
+    uint8_t getTemplateCount() {
+        uint8_t cmd[] = {FINGERPRINT_TEMPLATECOUNT};
+        uint8_t p = command(cmd, sizeof(cmd));
+        if (replyLen >= 3) {
+            templateCount = be16(1);
+        }
+        return p;
+    }
+
+    uint16_t fingerID = 0, confidence = 0, templateCount = 0;
+    uint16_t status_reg = 0, system_id = 0, capacity = 64, security_level = 0;
+    uint32_t device_addr = 0xFFFFFFFF;
+    uint16_t packet_len = 64, baud_rate = 57600;
+
+private:
+    uint16_t be16(int i) const { return ((uint16_t)reply[i] << 8) | reply[i + 1]; }
+
+    uint8_t searchReply(uint8_t p) {
+        if (replyLen >= 5) {
+            fingerID = be16(1);
+            confidence = be16(3);
+        }
+        return p;
+    }
+
+    uint8_t command(const uint8_t* data, uint16_t len) {
+        uint16_t wireLen = len + 2;
+        uint8_t header[9] = {0xEF, 0x01, 0xFF, 0xFF, 0xFF, 0xFF, FINGERPRINT_COMMANDPACKET,
+                             (uint8_t)(wireLen >> 8), (uint8_t)wireLen};
+        uint16_t sum = FINGERPRINT_COMMANDPACKET + (wireLen >> 8) + (wireLen & 0xFF);
+        for (uint16_t i = 0; i < len; i++) sum += data[i];
+        uint8_t checksum[2] = {(uint8_t)(sum >> 8), (uint8_t)sum};
+
+        replyLen = 0;
+        port->write(header, sizeof(header));
+        port->write(data, len);
+        port->write(checksum, sizeof(checksum));
+        return readReply();
+    }
+
+    // Reads one acknowledge packet the way the library does: byte by byte
+    // with a timeout, so a missing reply costs simulated time, not a hang
+    uint8_t readReply() {
+        uint8_t header[9];
+        uint16_t idx = 0, length = 0;
+        unsigned long start = millis();
+
+        while (millis() - start < DEFAULTTIMEOUT) {
+            int c = port->read();
+            if (c < 0) {
+                delay(1);
+                continue;
+            }
+            if (idx < 9) {
+                if ((idx == 0 && c != 0xEF) || (idx == 1 && c != 0x01)) {
+                    idx = 0;
+                    continue;
+                }
+                header[idx++] = c;
+                if (idx == 9) length = ((uint16_t)header[7] << 8 | header[8]) - 2;
+                continue;
+            }
+            uint16_t pos = idx++ - 9;
+            if (pos < length && pos < sizeof(reply)) reply[pos] = c;
+            if (pos == length + 1) {
+                replyLen = length < sizeof(reply) ? length : sizeof(reply);
+                return header[6] == FINGERPRINT_ACKPACKET && length > 0 ? reply[0] : FINGERPRINT_BADPACKET;
+            }
+        }
+        return FINGERPRINT_TIMEOUT;
+    }
+
+    Stream* port;
+    uint32_t password;
+    uint8_t reply[32];
+    uint16_t replyLen = 0;
+};
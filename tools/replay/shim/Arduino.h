@@ -0,0 +1,207 @@
+#pragma once
+// Host stand-in for the Arduino core, just enough for the sketch to build and
+// run single-threaded under tools/replay. Time, serial ports and interrupts
+// are driven by the replay engine (replay.cpp).
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cstdarg>
+#include <deque>
+#include <string>
+
+#define IRAM_ATTR
+#define F(x) x
+#define DEC 10
+#define HEX 16
+#define INPUT 1
+#define INPUT_PULLUP 2
+#define FALLING 2
+#define RISING 1
+#define CHANGE 3
+#define HIGH 1
+#define LOW 0
+#define SERIAL_8N1 0
+#define ESP_ARDUINO_VERSION_MAJOR 3
+
+typedef bool boolean;
+typedef uint8_t byte;
+typedef int esp_err_t;
+#define ESP_OK 0
+#define ESP_FAIL -1
+#define ESP_ERR_INVALID_STATE 0x103
+
+class String {
+public:
+    String() {}
+    String(const char* c) : s(c ? c : "") {}
+    String(const std::string& c) : s(c) {}
+    explicit String(char c) : s(1, c) {}
+    String(int v, int base = 10) { format(base == 16 ? "%x" : "%d", v); }
+    String(unsigned v, int base = 10) { format(base == 16 ? "%x" : "%u", v); }
+    String(long v, int base = 10) { format(base == 16 ? "%lx" : "%ld", v); }
+    String(unsigned long v, int base = 10) { format(base == 16 ? "%lx" : "%lu", v); }
+    String(long long v) { format("%lld", v); }
+    String(unsigned long long v) { format("%llu", v); }
+    String(float v, int decimals = 2) { format("%.*f", decimals, (double)v); }
+    String(double v, int decimals = 2) { format("%.*f", decimals, v); }
+
+    unsigned length() const { return s.size(); }
+    const char* c_str() const { return s.c_str(); }
+    bool isEmpty() const { return s.empty(); }
+    int toInt() const { return atoi(s.c_str()); }
+    char operator[](unsigned i) const { return i < s.size() ? s[i] : 0; }
+    String substring(unsigned from) const { return from < s.size() ? s.substr(from) : ""; }
+    String substring(unsigned from, unsigned to) const { return from < s.size() ? s.substr(from, to - from) : ""; }
+    int indexOf(char c, unsigned from = 0) const { size_t p = s.find(c, from); return p == std::string::npos ? -1 : (int)p; }
+    bool startsWith(const String& p) const { return s.rfind(p.s, 0) == 0; }
+    bool endsWith(const String& p) const { return s.size() >= p.s.size() && s.compare(s.size() - p.s.size(), p.s.size(), p.s) == 0; }
+    bool reserve(unsigned n) { s.reserve(n); return true; }
+    bool concat(const String& o) { s += o.s; return true; }
+    bool concat(const char* c, unsigned n) { s.append(c, n); return true; }
+    void trim() {
+        size_t a = s.find_first_not_of(" \t\r\n");
+        size_t b = s.find_last_not_of(" \t\r\n");
+        s = a == std::string::npos ? "" : s.substr(a, b - a + 1);
+    }
+    void toLowerCase() { for (auto& c : s) c = tolower(c); }
+
+    bool operator==(const String& o) const { return s == o.s; }
+    bool operator==(const char* o) const { return s == (o ? o : ""); }
+    bool operator!=(const String& o) const { return s != o.s; }
+    bool operator!=(const char* o) const { return s != (o ? o : ""); }
+    String& operator+=(const String& o) { s += o.s; return *this; }
+    String& operator+=(const char* o) { s += o; return *this; }
+    String& operator+=(char o) { s += o; return *this; }
+
+    std::string s;
+
+private:
+    template <class... T> void format(const char* fmt, T... v) {
+        char b[48];
+        snprintf(b, sizeof(b), fmt, v...);
+        s = b;
+    }
+};
+
+inline String operator+(const String& a, const String& b) { return a.s + b.s; }
+inline String operator+(const String& a, const char* b) { return a.s + b; }
+inline String operator+(const char* a, const String& b) { return a + b.s; }
+inline String operator+(const String& a, char b) { return a.s + b; }
+
+class Print;
+
+class Printable {
+public:
+    virtual ~Printable() {}
+    virtual size_t printTo(Print& p) const = 0;
+};
+
+class Print {
+public:
+    virtual ~Print() {}
+    virtual size_t write(uint8_t c) = 0;
+    virtual size_t write(const uint8_t* buffer, size_t size) {
+        size_t n = 0;
+        while (size--) n += write(*buffer++);
+        return n;
+    }
+    virtual void flush() {}
+
+    size_t write(const char* str) { return write((const uint8_t*)str, strlen(str)); }
+    size_t print(const String& v) { return write((const uint8_t*)v.c_str(), v.length()); }
+    size_t print(const char* v) { return write(v); }
+    size_t print(char v) { return write((uint8_t)v); }
+    size_t print(int v, int base = DEC) { return print(String(v, base)); }
+    size_t print(unsigned v, int base = DEC) { return print(String(v, base)); }
+    size_t print(long v, int base = DEC) { return print(String(v, base)); }
+    size_t print(unsigned long v, int base = DEC) { return print(String(v, base)); }
+    size_t print(double v, int digits = 2) { return print(String(v, digits)); }
+    size_t print(const Printable& v) { return v.printTo(*this); }
+    size_t println() { return write("\r\n"); }
+    template <class T> size_t println(const T& v) { return print(v) + println(); }
+    template <class T> size_t println(const T& v, int base) { return print(v, base) + println(); }
+    size_t printf(const char* fmt, ...) {
+        char b[256];
+        va_list args;
+        va_start(args, fmt);
+        int n = vsnprintf(b, sizeof(b), fmt, args);
+        va_end(args);
+        return write((const uint8_t*)b, n < (int)sizeof(b) ? n : sizeof(b) - 1);
+    }
+};
+
+class Stream : public Print {
+public:
+    virtual int available() = 0;
+    virtual int read() = 0;
+    virtual int peek() = 0;
+
+    void setTimeout(unsigned long) {}
+    size_t readBytes(uint8_t* buffer, size_t length) {
+        size_t n = 0;
+        int c;
+        while (n < length && (c = read()) >= 0) buffer[n++] = c;
+        return n;
+    }
+    String readStringUntil(char terminator) {
+        String out;
+        int c;
+        while ((c = read()) >= 0 && c != terminator) out += (char)c;
+        return out;
+    }
+};
+
+// UART 0 is the console (stdout); other UARTs are sensors served by the replay
+class HardwareSerial : public Stream {
+public:
+    explicit HardwareSerial(int uart) : uart(uart) {}
+    void begin(unsigned long, uint32_t = 0, int8_t = -1, int8_t = -1) {}
+    void end() {}
+    void setRxBufferSize(size_t) {}
+    operator bool() const { return true; }
+
+    int available() override { return rx.size(); }
+    int peek() override { return rx.empty() ? -1 : rx.front(); }
+    int read() override {
+        if (rx.empty()) return -1;
+        int c = rx.front();
+        rx.pop_front();
+        return c;
+    }
+    size_t write(uint8_t c) override;
+    using Print::write;
+
+    const int uart;
+    std::deque<uint8_t> rx;
+};
+
+extern HardwareSerial Serial;
+
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned us);
+void yield();
+
+void pinMode(int pin, int mode);
+int digitalRead(int pin);
+inline int digitalPinToInterrupt(int pin) { return pin; }
+void attachInterrupt(int pin, void (*isr)(), int mode);
+void detachInterrupt(int pin);
+
+template <class T> T constrain(T v, T lo, T hi) { return v < lo ? lo : v > hi ? hi : v; }
+template <class T, class U> auto min(T a, U b) -> decltype(a + b) { return a < b ? a : b; }
+template <class T, class U> auto max(T a, U b) -> decltype(a + b) { return a > b ? a : b; }
+
+struct EspClass {
+    void restart();
+    uint32_t getFreeHeap() { return 200000; }
+    uint32_t getMinFreeHeap() { return 150000; }
+};
+extern EspClass ESP;
+
+inline uint32_t esp_random() { return 0x5EED0001; }
+
+#include "freertos_shim.h"
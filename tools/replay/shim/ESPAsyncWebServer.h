@@ -0,0 +1,74 @@
+#pragma once
+// The web server is inert during replay: routes are accepted and never called
+#include "Arduino.h"
+#include "LittleFS.h"
+#include <functional>
+
+typedef enum { HTTP_GET = 1, HTTP_POST = 2, HTTP_ANY = 255 } WebRequestMethod;
+
+class AsyncWebParameter {
+public:
+    const String& name() const { return empty; }
+    const String& value() const { return empty; }
+    bool isPost() const { return true; }
+
+private:
+    String empty;
+};
+
+class AsyncWebHeader {
+public:
+    const String& value() const { return empty; }
+
+private:
+    String empty;
+};
+
+class AsyncWebServerResponse {
+public:
+    void addHeader(const char*, const char*) {}
+};
+
+class AsyncWebServerRequest {
+public:
+    int params() const { return 0; }
+    const AsyncWebParameter* getParam(int) const { return nullptr; }
+    const AsyncWebHeader* getHeader(const char*) const { return nullptr; }
+    void send(int, const char* = "", const String& = String()) {}
+    void send(fs::LittleFSFS&, const char*, const char*) {}
+    void send(AsyncWebServerResponse* response) { delete response; }
+    void onDisconnect(std::function<void()>) {}
+    AsyncWebServerResponse* beginChunkedResponse(const char*, std::function<size_t(uint8_t*, size_t, size_t)>) {
+        return new AsyncWebServerResponse;
+    }
+    AsyncWebServerResponse* beginResponse(int, const char* = "", const String& = String()) { return new AsyncWebServerResponse; }
+    AsyncWebServerResponse* beginResponse(int, const char*, const uint8_t*, size_t) { return new AsyncWebServerResponse; }
+};
+
+typedef std::function<void(AsyncWebServerRequest*)> ArRequestHandlerFunction;
+
+class AsyncWebHandler {};
+
+class AsyncEventSourceClient {
+public:
+    bool send(const char*, const char* = nullptr, uint32_t = 0, uint32_t = 0) { return true; }
+    size_t packetsWaiting() const { return 0; }
+    void close() {}
+};
+
+typedef std::function<void(AsyncEventSourceClient*)> ArEventHandlerFunction;
+
+class AsyncEventSource : public AsyncWebHandler {
+public:
+    explicit AsyncEventSource(const char*) {}
+    void onConnect(ArEventHandlerFunction) {}
+    void onDisconnect(ArEventHandlerFunction) {}
+};
+
+class AsyncWebServer {
+public:
+    explicit AsyncWebServer(uint16_t) {}
+    void begin() {}
+    void on(const char*, WebRequestMethod, ArRequestHandlerFunction) {}
+    AsyncWebHandler& addHandler(AsyncWebHandler* handler) { return *handler; }
+};
@@ -0,0 +1,36 @@
+#pragma once
+// 16x2 character buffer; replay.cpp prints it whenever the text changes
+#include "Arduino.h"
+
+class LiquidCrystal_I2C : public Print {
+public:
+    LiquidCrystal_I2C(uint8_t, uint8_t cols, uint8_t rows) : cols(cols), rows(rows) { clear(); }
+    void init() {}
+    void begin() {}
+    void backlight() {}
+    void noBacklight() {}
+    void clear() {
+        for (int r = 0; r < 4; r++) {
+            memset(lines[r], ' ', sizeof(lines[r]) - 1);
+            lines[r][cols] = '\0';
+        }
+        col = row = 0;
+        dirty = true;
+    }
+    void setCursor(uint8_t c, uint8_t r) { col = c; row = r; }
+    size_t write(uint8_t c) override {
+        if (row < rows && col < cols) {
+            lines[row][col] = c;
+            dirty = true;
+        }
+        col++;
+        return 1;
+    }
+    using Print::write;
+
+    char lines[4][41];
+    bool dirty = false;
+
+private:
+    uint8_t cols, rows, col = 0, row = 0;
+};
@@ -0,0 +1,69 @@
+#pragma once
+// LittleFS backed by a host directory (replay --fs DIR), so the attendance
+// log and WiFi settings a replay produces can be inspected and diffed
+#include "Arduino.h"
+#include <memory>
+#include <sys/stat.h>
+
+#define FILE_READ "r"
+#define FILE_WRITE "w"
+#define FILE_APPEND "a"
+
+namespace fs {
+
+class File : public Stream {
+public:
+    File() {}
+    explicit File(FILE* file) {
+        if (file != nullptr) f.reset(file, fclose);
+    }
+    operator bool() const { return (bool)f; }
+    bool isDirectory() const { return false; }
+    void close() { f.reset(); }
+    size_t size() const {
+        long pos = ftell(f.get());
+        fseek(f.get(), 0, SEEK_END);
+        long end = ftell(f.get());
+        fseek(f.get(), pos, SEEK_SET);
+        return end;
+    }
+    int available() override { return f ? (int)(size() - ftell(f.get())) : 0; }
+    int read() override { return f ? fgetc(f.get()) : -1; }
+    int peek() override {
+        int c = read();
+        if (c >= 0) ungetc(c, f.get());
+        return c;
+    }
+    size_t read(uint8_t* buffer, size_t n) { return f ? fread(buffer, 1, n, f.get()) : 0; }
+    size_t write(uint8_t c) override { return write(&c, 1); }
+    size_t write(const uint8_t* buffer, size_t n) override { return f ? fwrite(buffer, 1, n, f.get()) : 0; }
+    using Print::write;
+
+private:
+    std::shared_ptr<FILE> f;
+};
+
+class LittleFSFS {
+public:
+    bool begin(bool = false) { mkdir(root.c_str(), 0755); return true; }
+    File open(const char* path, const char* mode = FILE_READ) {
+        std::string m = std::string(mode) + "b";
+        return File(fopen(full(path).c_str(), m.c_str()));
+    }
+    bool exists(const char* path) {
+        struct stat st;
+        return stat(full(path).c_str(), &st) == 0;
+    }
+    bool remove(const char* path) { return ::remove(full(path).c_str()) == 0; }
+    bool rename(const char* from, const char* to) { return ::rename(full(from).c_str(), full(to).c_str()) == 0; }
+
+    std::string root = "replay_fs";
+
+private:
+    std::string full(const char* path) { return root + path; }
+};
+
+}  // namespace fs
+
+using fs::File;
+extern fs::LittleFSFS LittleFS;
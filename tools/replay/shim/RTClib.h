@@ -0,0 +1,72 @@
+#pragma once
+// DateTime with real calendar math; the DS3231 answers from the trace
+#include "Arduino.h"
+
+class DateTime {
+public:
+    DateTime(uint32_t t = 0) { fromUnix(t); }
+
+    DateTime(uint16_t y, uint8_t m, uint8_t d, uint8_t hh = 0, uint8_t mm = 0, uint8_t ss = 0)
+        : y(y), m(m), d(d), hh(hh), mm(mm), ss(ss) {}
+
+    // __DATE__ ("Oct 19 2026") and __TIME__ ("04:12:56")
+    DateTime(const char* date, const char* time) {
+        static const char months[] = "JanFebMarAprMayJunJulAugSepOctNovDec";
+        char mon[4] = {date[0], date[1], date[2], 0};
+        m = (strstr(months, mon) - months) / 3 + 1;
+        d = atoi(date + 4);
+        y = atoi(date + 7);
+        hh = atoi(time);
+        mm = atoi(time + 3);
+        ss = atoi(time + 6);
+    }
+
+    uint16_t year() const { return y; }
+    uint8_t month() const { return m; }
+    uint8_t day() const { return d; }
+    uint8_t hour() const { return hh; }
+    uint8_t minute() const { return mm; }
+    uint8_t second() const { return ss; }
+
+    uint32_t unixtime() const {
+        // days_from_civil (H. Hinnant)
+        int yy = y - (m <= 2);
+        int era = (yy >= 0 ? yy : yy - 399) / 400;
+        unsigned yoe = yy - era * 400;
+        unsigned doy = (153 * (m + (m > 2 ? -3 : 9)) + 2) / 5 + d - 1;
+        unsigned doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+        long days = (long)era * 146097 + doe - 719468;
+        return days * 86400 + hh * 3600 + mm * 60 + ss;
+    }
+
+private:
+    void fromUnix(uint32_t t) {
+        long days = t / 86400;
+        uint32_t rem = t % 86400;
+        hh = rem / 3600;
+        mm = rem / 60 % 60;
+        ss = rem % 60;
+        days += 719468;
+        long era = days / 146097;
+        unsigned doe = days - era * 146097;
+        unsigned yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+        unsigned doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+        unsigned mp = (5 * doy + 2) / 153;
+        d = doy - (153 * mp + 2) / 5 + 1;
+        m = mp < 10 ? mp + 3 : mp - 9;
+        y = yoe + era * 400 + (m <= 2);
+    }
+
+    uint16_t y = 2000;
+    uint8_t m = 1, d = 1, hh = 0, mm = 0, ss = 0;
+};
+
+uint32_t replayRtcRead();
+
+class RTC_DS3231 {
+public:
+    bool begin() { return true; }
+    bool lostPower() { return false; }
+    void adjust(const DateTime&) {}
+    DateTime now() { return DateTime(replayRtcRead()); }
+};
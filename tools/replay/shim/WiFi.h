@@ -0,0 +1,72 @@
+#pragma once
+// WiFi state follows the recorded events; replay.cpp delivers them
+#include "Arduino.h"
+
+class IPAddress : public Printable {
+public:
+    IPAddress() {}
+    IPAddress(uint8_t a, uint8_t b, uint8_t c, uint8_t d) : addr{a, b, c, d} {}
+    bool fromString(const char* s) {
+        unsigned a, b, c, d;
+        if (sscanf(s, "%u.%u.%u.%u", &a, &b, &c, &d) != 4) return false;
+        *this = IPAddress(a, b, c, d);
+        return true;
+    }
+    String toString() const {
+        char b[16];
+        snprintf(b, sizeof(b), "%u.%u.%u.%u", addr[0], addr[1], addr[2], addr[3]);
+        return b;
+    }
+    size_t printTo(Print& p) const override { return p.print(toString()); }
+
+private:
+    uint8_t addr[4] = {0, 0, 0, 0};
+};
+
+typedef enum { WL_IDLE_STATUS = 0, WL_CONNECTED = 3, WL_CONNECT_FAILED = 4, WL_DISCONNECTED = 6 } wl_status_t;
+#define WIFI_STA 1
+#define WIFI_AP 2
+
+typedef int arduino_event_id_t;
+#define ARDUINO_EVENT_WIFI_STA_START 2
+#define ARDUINO_EVENT_WIFI_STA_CONNECTED 4
+#define ARDUINO_EVENT_WIFI_STA_DISCONNECTED 5
+#define ARDUINO_EVENT_WIFI_STA_GOT_IP 7
+#define ARDUINO_EVENT_WIFI_STA_LOST_IP 8
+typedef struct { int unused; } arduino_event_info_t;
+typedef int wifi_event_id_t;
+typedef void (*WiFiEventFullCb)(arduino_event_id_t, arduino_event_info_t);
+
+class WiFiClass {
+public:
+    bool mode(int) { return true; }
+    int begin(const char* ssid, const char* = nullptr) { configuredSSID = ssid; return WL_DISCONNECTED; }
+    bool config(IPAddress ip, IPAddress, IPAddress) { configuredIP = ip; return true; }
+    wl_status_t status() { return connected ? WL_CONNECTED : WL_DISCONNECTED; }
+    IPAddress localIP() { return connected ? configuredIP : IPAddress(); }
+    String SSID() { return connected ? configuredSSID : String(); }
+    int8_t RSSI() { return connected ? -60 : 0; }
+    bool softAP(const char*, const char*) { return true; }
+    IPAddress softAPIP() { return IPAddress(192, 168, 4, 1); }
+    bool disconnect(bool = false) { return true; }
+    wifi_event_id_t onEvent(WiFiEventFullCb cb, arduino_event_id_t = 0) {
+        if (callbackCount < 8) callbacks[callbackCount++] = cb;
+        return callbackCount;
+    }
+
+    // Replay side
+    void deliver(arduino_event_id_t event) {
+        if (event == ARDUINO_EVENT_WIFI_STA_GOT_IP) connected = true;
+        if (event == ARDUINO_EVENT_WIFI_STA_DISCONNECTED || event == ARDUINO_EVENT_WIFI_STA_LOST_IP) connected = false;
+        arduino_event_info_t info = {};
+        for (int i = 0; i < callbackCount; i++) callbacks[i](event, info);
+    }
+
+private:
+    bool connected = false;
+    IPAddress configuredIP;
+    String configuredSSID;
+    WiFiEventFullCb callbacks[8];
+    int callbackCount = 0;
+};
+extern WiFiClass WiFi;
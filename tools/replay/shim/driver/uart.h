@@ -0,0 +1,33 @@
+#pragma once
+// The IDF UART driver is only used by R30xAsyncDriver (sensor benchmark),
+// which the replay never runs; installing it fails so nothing touches it.
+#include "Arduino.h"
+
+typedef int uart_port_t;
+typedef enum { UART_DATA, UART_BREAK, UART_BUFFER_FULL, UART_FIFO_OVF, UART_FRAME_ERR, UART_PARITY_ERR,
+               UART_DATA_BREAK, UART_PATTERN_DET, UART_EVENT_MAX } uart_event_type_t;
+typedef struct { uart_event_type_t type; size_t size; bool timeout_flag; } uart_event_t;
+typedef enum { UART_DATA_8_BITS = 3 } uart_word_length_t;
+typedef enum { UART_PARITY_DISABLE = 0 } uart_parity_t;
+typedef enum { UART_STOP_BITS_1 = 1 } uart_stop_bits_t;
+typedef enum { UART_HW_FLOWCTRL_DISABLE = 0 } uart_hw_flowcontrol_t;
+typedef enum { UART_SCLK_APB = 0, UART_SCLK_DEFAULT = 0 } uart_sclk_t;
+typedef struct {
+    int baud_rate;
+    uart_word_length_t data_bits;
+    uart_parity_t parity;
+    uart_stop_bits_t stop_bits;
+    uart_hw_flowcontrol_t flow_ctrl;
+    uint8_t rx_flow_ctrl_thresh;
+    uart_sclk_t source_clk;
+} uart_config_t;
+#define UART_PIN_NO_CHANGE (-1)
+
+inline esp_err_t uart_driver_install(uart_port_t, int, int, int, QueueHandle_t*, int) { return ESP_FAIL; }
+inline esp_err_t uart_driver_delete(uart_port_t) { return ESP_OK; }
+inline esp_err_t uart_param_config(uart_port_t, const uart_config_t*) { return ESP_OK; }
+inline esp_err_t uart_set_pin(uart_port_t, int, int, int, int) { return ESP_OK; }
+inline esp_err_t uart_set_rx_timeout(uart_port_t, uint8_t) { return ESP_OK; }
+inline int uart_write_bytes(uart_port_t, const void*, size_t) { return -1; }
+inline int uart_read_bytes(uart_port_t, void*, uint32_t, TickType_t) { return -1; }
+inline esp_err_t uart_flush_input(uart_port_t) { return ESP_OK; }
@@ -0,0 +1,403 @@
+#pragma once
+#include <Arduino.h>
+#include <WiFi.h>
+#include <RTClib.h>
+#include <esp_system.h>
+#include "LittleFS.h"
+#include "r30x_async.h"
+
+// Input trace for offline replay (tools/replay).
+//
+// Everything the firmware reacts to from the outside is recorded as a 20-byte
+// TraceRecord: sensor replies with their latency, button ISR edges, RTC reads,
+// WiFi events and serial console input. Records go into a RAM ring (also from
+// the button ISRs) and handleTrace() appends them to TRACE_PATH from loop().
+// Identical consecutive replies from one sensor, like "no finger" every
+// SCAN_POLL_MS, fold into one record with a repeat count. A fold stays open
+// across flushes: repeats counted after its record went to flash are written
+// as one TRACE_SENSOR_REPEAT record when the reply changes (or on
+// traceFlushAll() before a restart). Clock reads are folded the same way:
+// one that matches the last traced reading plus the elapsed millis() is what
+// the replay computes anyway, so only clock jumps and phase slips are
+// recorded. An idle device (polls plus the status screen clock) writes
+// almost nothing.
+//
+// File layout (little-endian): a TraceHeader, then records. Each boot starts
+// with a TRACE_BOOT record; past TRACE_FILE_MAX the file moves to
+// TRACE_OLD_PATH and a new one is started.
+
+#define TRACE_PATH "/trace.bin"
+#define TRACE_OLD_PATH "/trace.old"
+#define TRACE_MAGIC 0x31545349UL  // "IST1"
+#define TRACE_VERSION 2  // 2: TRACE_SENSOR_REPEAT
+#define TRACE_RING_RECORDS 128
+#define TRACE_FILE_MAX (64 * 1024)
+#define TRACE_FLUSH_MS 30000
+#define TRACE_DATA_LEN 8
+#define TRACE_MAX_SOURCES 4
+
+enum TraceType : uint8_t {
+    TRACE_BOOT,         // op: esp_reset_reason()
+    TRACE_SENSOR,       // source: sensor, op: command, len: reply payload bytes
+    TRACE_SENSOR_MORE,  // next TRACE_DATA_LEN bytes of the previous reply
+    TRACE_SENSOR_DATA,  // data packet; op: packet id, data[0..1]: length
+    TRACE_BUTTON,       // source: MenuKey, op: 1 accepted, 0 debounced
+    TRACE_RTC,          // data[0..3]: unixtime
+    TRACE_WIFI,         // op: arduino_event_id_t
+    TRACE_DROPPED,      // repeat: records lost to a full ring
+    TRACE_CONSOLE,      // op: byte typed on the serial console
+    TRACE_SENSOR_REPEAT // source: sensor, repeat: more folds of its last reply
+};
+
+struct TraceHeader {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t recordSize;
+};
+
+struct TraceRecord {
+    uint32_t ms;
+    uint8_t type;
+    uint8_t source;
+    uint8_t op;
+    uint8_t len;
+    uint16_t latencyMs;
+    uint16_t repeat;    // further identical replies folded into this record
+    uint8_t data[TRACE_DATA_LEN];
+};
+
+static_assert(sizeof(TraceRecord) == 20, "TraceRecord is part of the trace file format");
+
+bool traceEnabled = true;
+
+static TraceRecord traceRing[TRACE_RING_RECORDS];
+static TraceRecord traceStaging[TRACE_RING_RECORDS];
+static uint16_t traceHead = 0;
+static volatile uint16_t traceCount = 0;
+// Open fold per sensor: the reply being repeated, where its record sits in
+// the ring until the next flush, and repeats counted after that
+static bool traceFoldOpen[TRACE_MAX_SOURCES] = {};
+static TraceRecord traceFoldReply[TRACE_MAX_SOURCES];
+static int16_t traceFoldSlot[TRACE_MAX_SOURCES] = {-1, -1, -1, -1};
+static uint16_t traceFoldPending[TRACE_MAX_SOURCES] = {};
+static portMUX_TYPE traceMux = portMUX_INITIALIZER_UNLOCKED;
+static bool traceReady = false;
+static unsigned long traceLastFlush = 0;
+
+// Statistics
+static uint32_t traceRecorded = 0;
+static uint32_t traceFolded = 0;
+static uint32_t traceDropped = 0;
+static uint32_t traceDroppedPending = 0;
+static uint32_t traceWritten = 0;
+
+static IRAM_ATTR TraceRecord* traceAllocLocked(uint8_t type, uint8_t source, uint8_t op) {
+    if (traceCount == TRACE_RING_RECORDS) {
+        traceDropped++;
+        traceDroppedPending++;
+        return nullptr;
+    }
+    TraceRecord* r = &traceRing[(traceHead + traceCount) % TRACE_RING_RECORDS];
+    traceCount++;
+    traceRecorded++;
+
+    memset(r, 0, sizeof(*r));
+    r->ms = millis();
+    r->type = type;
+    r->source = source;
+    r->op = op;
+    return r;
+}
+
+static void traceEvent(uint8_t type, uint8_t source, uint8_t op, const void* data, uint8_t len) {
+    if (!traceEnabled) {
+        return;
+    }
+    portENTER_CRITICAL(&traceMux);
+    TraceRecord* r = traceAllocLocked(type, source, op);
+    if (r != nullptr) {
+        r->len = len;
+        memcpy(r->data, data, min(len, (uint8_t)TRACE_DATA_LEN));
+    }
+    portEXIT_CRITICAL(&traceMux);
+}
+
+void IRAM_ATTR traceButtonISR(uint8_t key, bool accepted) {
+    if (!traceEnabled) {
+        return;
+    }
+    portENTER_CRITICAL_ISR(&traceMux);
+    traceAllocLocked(TRACE_BUTTON, key, accepted ? 1 : 0);
+    portEXIT_CRITICAL_ISR(&traceMux);
+}
+
+// Ends the open fold of `source`, recording repeats its flushed record misses
+static void traceFoldCloseLocked(uint8_t source) {
+    if (traceFoldPending[source] > 0) {
+        TraceRecord* r = traceAllocLocked(TRACE_SENSOR_REPEAT, source, traceFoldReply[source].op);
+        if (r != nullptr) {
+            r->repeat = traceFoldPending[source];
+        }
+    }
+    traceFoldOpen[source] = false;
+    traceFoldSlot[source] = -1;
+    traceFoldPending[source] = 0;
+}
+
+void traceSensorReply(uint8_t source, uint8_t command, const uint8_t* payload, uint16_t len, uint32_t latencyMs) {
+    if (!traceEnabled || source >= TRACE_MAX_SOURCES) {
+        return;
+    }
+
+    portENTER_CRITICAL(&traceMux);
+    const TraceRecord& last = traceFoldReply[source];
+    if (traceFoldOpen[source] && last.op == command && last.len == len &&
+        memcmp(last.data, payload, len) == 0) {
+        int16_t fold = traceFoldSlot[source];
+        uint16_t& repeat = fold >= 0 ? traceRing[fold].repeat : traceFoldPending[source];
+        if (repeat < 0xFFFF) {
+            repeat++;
+            traceFolded++;
+            portEXIT_CRITICAL(&traceMux);
+            return;
+        }
+    }
+
+    traceFoldCloseLocked(source);
+    TraceRecord* r = traceAllocLocked(TRACE_SENSOR, source, command);
+    if (r != nullptr) {
+        r->len = len;
+        r->latencyMs = min(latencyMs, (uint32_t)0xFFFF);
+        memcpy(r->data, payload, min(len, (uint16_t)TRACE_DATA_LEN));
+        if (len <= TRACE_DATA_LEN) {
+            traceFoldOpen[source] = true;
+            traceFoldReply[source] = *r;
+            traceFoldSlot[source] = r - traceRing;
+        }
+
+        for (uint16_t offset = TRACE_DATA_LEN; offset < len; offset += TRACE_DATA_LEN) {
+            TraceRecord* more = traceAllocLocked(TRACE_SENSOR_MORE, source, command);
+            if (more == nullptr) {
+                break;
+            }
+            more->len = min((uint16_t)(len - offset), (uint16_t)TRACE_DATA_LEN);
+            memcpy(more->data, payload + offset, more->len);
+        }
+    }
+    portEXIT_CRITICAL(&traceMux);
+}
+
+// Template data packets are only traced by size
+void traceSensorData(uint8_t source, uint8_t pid, uint16_t len) {
+    if (!traceEnabled || source >= TRACE_MAX_SOURCES) {
+        return;
+    }
+    portENTER_CRITICAL(&traceMux);
+    traceFoldCloseLocked(source);
+    TraceRecord* r = traceAllocLocked(TRACE_SENSOR_DATA, source, pid);
+    if (r != nullptr) {
+        r->len = 2;
+        memcpy(r->data, &len, sizeof(len));
+    }
+    portEXIT_CRITICAL(&traceMux);
+}
+
+// Last clock reading that went into the trace
+static bool traceRtcAnchored = false;
+static uint32_t traceRtcMs = 0;
+static uint32_t traceRtcUnixtime = 0;
+
+// Same rule as replayRtcRead() in tools/replay: a reading is predictable
+// from the last traced one plus whole seconds of millis() since then
+static void traceRtcRead(uint32_t unixtime) {
+    if (!traceEnabled) {
+        return;
+    }
+    portENTER_CRITICAL(&traceMux);
+    if (traceRtcAnchored && unixtime == traceRtcUnixtime + (millis() - traceRtcMs) / 1000) {
+        traceFolded++;
+        portEXIT_CRITICAL(&traceMux);
+        return;
+    }
+    TraceRecord* r = traceAllocLocked(TRACE_RTC, 0, 0);
+    // A dropped reading must not become the anchor the replay never sees
+    traceRtcAnchored = r != nullptr;
+    if (r != nullptr) {
+        r->len = sizeof(unixtime);
+        memcpy(r->data, &unixtime, sizeof(unixtime));
+        traceRtcMs = r->ms;
+        traceRtcUnixtime = unixtime;
+    }
+    portEXIT_CRITICAL(&traceMux);
+}
+
+// Use instead of rtc.now() so clock reads show up in the trace
+DateTime rtcNow() {
+    extern RTC_DS3231 rtc;
+    DateTime now = rtc.now();
+    traceRtcRead(now.unixtime());
+    return now;
+}
+
+void traceConsoleByte(uint8_t c) {
+    traceEvent(TRACE_CONSOLE, 0, c, nullptr, 0);
+}
+
+// Runs in the WiFi event task
+void traceWiFiEvent(arduino_event_id_t event, arduino_event_info_t info) {
+    traceEvent(TRACE_WIFI, 0, (uint8_t)event, nullptr, 0);
+}
+
+// Sits between Adafruit_Fingerprint (and the raw packet helpers) and a sensor
+// UART. Both directions go through a packet parser, so every reply is traced
+// with the command it answers and the time since that command went out.
+class TraceStream : public Stream {
+public:
+    TraceStream(Stream& port, uint8_t source) : port(port), source(source) {}
+
+    int available() override { return port.available(); }
+    int peek() override { return port.peek(); }
+
+    int read() override {
+        int b = port.read();
+        if (b >= 0 && traceEnabled && rx.feed((uint8_t)b)) {
+            if (rx.pid == FINGERPRINT_ACKPACKET && !rx.truncated()) {
+                traceSensorReply(source, command, rx.payload, rx.length, millis() - sentAt);
+            } else {
+                traceSensorData(source, rx.pid, rx.length);
+            }
+        }
+        return b;
+    }
+
+    size_t write(uint8_t b) override {
+        sent(b);
+        return port.write(b);
+    }
+
+    size_t write(const uint8_t* buffer, size_t size) override {
+        for (size_t i = 0; i < size; i++) {
+            sent(buffer[i]);
+        }
+        return port.write(buffer, size);
+    }
+
+    void flush() override { port.flush(); }
+
+private:
+    void sent(uint8_t b) {
+        if (traceEnabled && tx.feed(b) && tx.pid == FINGERPRINT_COMMANDPACKET) {
+            command = tx.payload[0];
+            sentAt = millis();
+        }
+    }
+
+    Stream& port;
+    const uint8_t source;
+    R30xParser tx;
+    R30xParser rx;
+    uint8_t command = 0;
+    unsigned long sentAt = 0;
+};
+
+static File traceOpen() {
+    if (LittleFS.exists(TRACE_PATH)) {
+        File file = LittleFS.open(TRACE_PATH, FILE_APPEND);
+        if (!file || file.size() < TRACE_FILE_MAX) {
+            return file;
+        }
+        file.close();
+        LittleFS.remove(TRACE_OLD_PATH);
+        LittleFS.rename(TRACE_PATH, TRACE_OLD_PATH);
+    }
+
+    File file = LittleFS.open(TRACE_PATH, FILE_WRITE);
+    if (file) {
+        TraceHeader header = {TRACE_MAGIC, TRACE_VERSION, sizeof(TraceRecord)};
+        file.write((const uint8_t*)&header, sizeof(header));
+    }
+    return file;
+}
+
+void traceFlush() {
+    if (!traceReady) {
+        return;
+    }
+
+    portENTER_CRITICAL(&traceMux);
+    uint16_t n = traceCount;
+    for (uint16_t i = 0; i < n; i++) {
+        traceStaging[i] = traceRing[(traceHead + i) % TRACE_RING_RECORDS];
+    }
+    traceHead = 0;
+    traceCount = 0;
+    // Open folds carry on; further repeats are counted in traceFoldPending
+    for (int s = 0; s < TRACE_MAX_SOURCES; s++) {
+        traceFoldSlot[s] = -1;
+    }
+    uint32_t dropped = traceDroppedPending;
+    traceDroppedPending = 0;
+    portEXIT_CRITICAL(&traceMux);
+
+    traceLastFlush = millis();
+    if (n == 0 && dropped == 0) {
+        return;
+    }
+
+    File file = traceOpen();
+    if (!file) {
+        Serial.println("Trace: failed to open " TRACE_PATH);
+        return;
+    }
+    file.write((const uint8_t*)traceStaging, n * sizeof(TraceRecord));
+    if (dropped > 0) {
+        // The lost records came after everything staged above
+        TraceRecord marker = {};
+        marker.ms = millis();
+        marker.type = TRACE_DROPPED;
+        marker.repeat = min(dropped, (uint32_t)0xFFFF);
+        file.write((const uint8_t*)&marker, sizeof(marker));
+    }
+    file.close();
+    traceWritten += n;
+}
+
+// Closes every open fold and writes everything out, before a restart or when
+// tracing is switched off
+void traceFlushAll() {
+    portENTER_CRITICAL(&traceMux);
+    for (int s = 0; s < TRACE_MAX_SOURCES; s++) {
+        traceFoldCloseLocked(s);
+    }
+    portEXIT_CRITICAL(&traceMux);
+    traceFlush();
+}
+
+void initTrace() {
+    if (!LittleFS.begin(true)) {
+        Serial.println("Trace: LittleFS mount failed, trace stays in RAM");
+        return;
+    }
+    traceReady = true;
+    uint8_t reason = (uint8_t)esp_reset_reason();
+    traceEvent(TRACE_BOOT, 0, reason, nullptr, 0);
+    Serial.println("Trace: recording to " TRACE_PATH ", reset reason " + String(reason));
+}
+
+void handleTrace() {
+    if (!traceReady) {
+        return;
+    }
+    if (traceCount >= TRACE_RING_RECORDS / 2 ||
+        ((traceCount > 0 || traceDroppedPending > 0) && millis() - traceLastFlush >= TRACE_FLUSH_MS)) {
+        traceFlush();
+    }
+}
+
+void printTraceStats() {
+    Serial.println("Trace " + String(traceEnabled ? "ON" : "OFF") +
+                   " recorded: " + String(traceRecorded) +
+                   " folded: " + String(traceFolded) +
+                   " written: " + String(traceWritten) +
+                   " dropped: " + String(traceDropped));
+}
@@ -13,6 +13,11 @@
 #include <ESPAsyncWebServer.h>
 #include <AsyncTCP.h>
 #include "LittleFS.h"
+#include "live_feed.h"
+#include "status_snapshot.h"
+#include "attendance_export.h"
+#include "config.h"
+#include "supervisor.h"
 
 //arduino-cli lib install "ESP Async WebServer"
 //arduino-cli lib install "AsyncTCP"
@@ -109,6 +114,7 @@ inline bool connectToWiFi() {
         return false;
     }
     
+    SupervisedScope scope(OP_WIFI_CONNECT);
     WiFi.begin(wifi_ssid.c_str(), wifi_pass.c_str());
     Serial.println("WiFi: Connecting...");
     
@@ -144,16 +150,21 @@ inline void startNormalMode() {
         request->send(200, "text/html", html);
     });
     
-    // Route for WiFi status API
-    wifiServer->on("/status", HTTP_GET, [](AsyncWebServerRequest *request) {
-        String json = "{";
-        json += "\"connected\": true,";
-        json += "\"ip\": \"" + WiFi.localIP().toString() + "\",";
-        json += "\"ssid\": \"" + WiFi.SSID() + "\"";
-        json += "}";
-        request->send(200, "application/json", json);
+    // Status API, served from a precomputed snapshot
+    initStatusSnapshot(wifiServer);
+    initLiveFeed(wifiServer);
+    
+    // Input trace for tools/replay
+    wifiServer->on(TRACE_PATH, HTTP_GET, [](AsyncWebServerRequest *request) {
+        request->send(LittleFS, TRACE_PATH, "application/octet-stream");
+    });
+    wifiServer->on(TRACE_OLD_PATH, HTTP_GET, [](AsyncWebServerRequest *request) {
+        request->send(LittleFS, TRACE_OLD_PATH, "application/octet-stream");
     });
     
+    // Compact attendance export, decoded with tools/export
+    initAttendanceExport(wifiServer);
+    
     wifiServer->begin();
 }
 
@@ -214,8 +225,9 @@ inline void startConfigMode() {
             }
         }
         request->send(200, "text/plain", "Configuration saved! ESP will restart and connect to: " + wifi_ip);
-        delay(3000);
-        ESP.restart();
+        
+        // Never block the async_tcp task; loop() performs the restart
+        supervisorScheduleRestart(3000);
     });
     
     wifiServer->begin();
@@ -239,6 +251,11 @@ inline bool initWiFiManager() {
     
     Serial.println("WiFi: Loaded config - SSID: " + wifi_ssid + ", IP: " + wifi_ip);
     
+    // Push connection changes to the live feed as they happen
+    WiFi.onEvent(liveFeedWiFiEvent);
+    WiFi.onEvent(statusWiFiEvent);
+    WiFi.onEvent(traceWiFiEvent);
+    
     // Try to connect with saved credentials
     if (connectToWiFi()) {
         startNormalMode();
@@ -280,6 +297,7 @@ inline void resetWiFiSettings() {
     wifi_gateway = "";
     
     Serial.println("WiFi: Configuration reset, restarting...");
+    traceFlushAll();
     ESP.restart();
 }
 